@@ -119,14 +119,20 @@ public:
   void
   setTypeConverter(TypeConverter converter);
 
-  ConnectionStyle style() const
+  ConnectionStyle const& style() const
   {
-      return _style;
+      return *_style;
   }
 
   void setStyle(ConnectionStyle style)
   {
-      _style = style;
+      _style = std::make_shared<const ConnectionStyle>( std::move(style) );
+  }
+
+  /// The style is shared, not copied
+  void setStyle(std::shared_ptr<const ConnectionStyle> style)
+  {
+      _style = std::move(style);
   }
 
 public: // data propagation
@@ -140,7 +146,7 @@ public: // data propagation
 private:
 
   QUuid _uid;
-  ConnectionStyle _style;
+  std::shared_ptr<const ConnectionStyle> _style;
 
 private:
 
@@ -35,7 +35,7 @@ Connection(PortType portType,
            Node& node,
            PortIndex portIndex)
   : _uid(QUuid::createUuid())
-  , _style(QtNodes::StyleCollection::connectionStyle())
+  , _style(std::make_shared<const ConnectionStyle>(QtNodes::StyleCollection::connectionStyle()))
   , _outPortIndex(INVALID)
   , _inPortIndex(INVALID)
   , _connectionState()
@@ -53,6 +53,7 @@ Connection(Node& nodeIn,
            PortIndex portIndexOut,
            TypeConverter typeConverter)
   : _uid(QUuid::createUuid())
+  , _style(std::make_shared<const ConnectionStyle>())
   , _outNode(&nodeOut)
   , _inNode(&nodeIn)
   , _outPortIndex(portIndexOut)
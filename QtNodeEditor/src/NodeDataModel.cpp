@@ -7,7 +7,7 @@ using QtNodes::NodeStyle;
 
 NodeDataModel::
 NodeDataModel()
-  : _nodeStyle(StyleCollection::nodeStyle())
+  : _nodeStyle(std::make_shared<const NodeStyle>(StyleCollection::nodeStyle()))
 {
     // Derived classes can initialize specific style here
 }
@@ -28,7 +28,7 @@ NodeStyle const&
 NodeDataModel::
 nodeStyle() const
 {
-  return _nodeStyle;
+  return *_nodeStyle;
 }
 
 
@@ -36,5 +36,13 @@ void
 NodeDataModel::
 setNodeStyle(NodeStyle const& style)
 {
-  _nodeStyle = style;
+  _nodeStyle = std::make_shared<const NodeStyle>(style);
+}
+
+
+void
+NodeDataModel::
+setNodeStyle(std::shared_ptr<const NodeStyle> style)
+{
+  _nodeStyle = std::move(style);
 }
@@ -18,7 +18,8 @@ GraphicContainer::GraphicContainer(std::shared_ptr<DataModelRegistry> model_regi
                                    QWidget *parent) :
     QObject(parent),
     _model_registry( std::move(model_registry) ),
-    _signal_was_blocked(true)
+    _signal_was_blocked(true),
+    _tree_index_valid(false)
 {
     _scene = new EditorFlowScene( _model_registry, parent );
     _view  = new QtNodes::FlowView( _scene, parent );
@@ -67,6 +68,18 @@ GraphicContainer::GraphicContainer(std::shared_ptr<DataModelRegistry> model_regi
         }
     });
 
+    // the order of the siblings depends on their position
+    connect( _scene, &QtNodes::FlowScene::nodeCreated,
+             this, &GraphicContainer::invalidateTreeIndex );
+    connect( _scene, &QtNodes::FlowScene::nodeDeleted,
+             this, &GraphicContainer::invalidateTreeIndex );
+    connect( _scene, &QtNodes::FlowScene::nodeMoved,
+             this, &GraphicContainer::invalidateTreeIndex );
+    connect( _scene, &QtNodes::FlowScene::connectionCreated,
+             this, &GraphicContainer::invalidateTreeIndex );
+    connect( _scene, &QtNodes::FlowScene::connectionDeleted,
+             this, &GraphicContainer::invalidateTreeIndex );
+
 }
 
 void GraphicContainer::lockEditing(bool locked)
@@ -160,6 +173,7 @@ void GraphicContainer::nodeReorder()
         NodeReorder( *_scene, abstract_tree );
         zoomHomeView();
     }
+    invalidateTreeIndex();
     emit undoableChange();
 }
 
@@ -229,6 +243,32 @@ void GraphicContainer::clearScene()
 {
     const QSignalBlocker blocker( this );
     _scene->clearScene();
+    invalidateTreeIndex();
+}
+
+const std::vector<GraphicContainer::IndexedNode>& GraphicContainer::treeIndex()
+{
+    if( _tree_index_valid )
+    {
+        return _tree_index;
+    }
+
+    const auto tree = BuildTreeFromScene( _scene );
+    _tree_index.clear();
+    _tree_index.reserve( tree.nodesCount() );
+
+    for (const auto& abs_node: tree.nodes())
+    {
+        IndexedNode indexed = { abs_node.graphic_node, nullptr };
+        const auto& conn_in = abs_node.graphic_node->nodeState().connections(PortType::In, 0 );
+        if( conn_in.size() == 1 )
+        {
+            indexed.input = conn_in.begin()->second;
+        }
+        _tree_index.push_back( indexed );
+    }
+    _tree_index_valid = true;
+    return _tree_index;
 }
 
 
@@ -463,6 +503,8 @@ void GraphicContainer::deleteSubTreeRecursively(Node &root_node)
     {
         _scene->removeNode( *delete_me );
     }
+    // nodeDeleted was not emitted
+    invalidateTreeIndex();
 }
 
 
@@ -662,6 +704,7 @@ void GraphicContainer::loadSceneFromTree(const AbsBehaviorTree &tree)
 {
     AbsBehaviorTree abs_tree = tree;
     _scene->clearScene();
+    invalidateTreeIndex();
 
     auto& first_qt_node = _scene->createNodeAtPos( "Root", "Root", QPointF(0,0) );
 
@@ -55,6 +55,16 @@ public:
 
     void createSubtree(QtNodes::Node& root_node, QString subtree_name = QString());
 
+    struct IndexedNode{
+        QtNodes::Node* node;
+        // nullptr if the node has no parent
+        QtNodes::Connection* input;
+    };
+
+    // The graphic nodes in the same order of BuildTreeFromScene(), i.e. by tree index.
+    // Built again only when nodes or connections were added, removed or moved.
+    const std::vector<IndexedNode>& treeIndex();
+
 public slots:
 
     void onNodeDoubleClicked(QtNodes::Node& root_node);
@@ -98,6 +108,12 @@ private:
 
    bool _signal_was_blocked;
 
+   void invalidateTreeIndex() { _tree_index_valid = false; }
+
+   // invalidated by the signals of the scene: who blocks them must call invalidateTreeIndex()
+   std::vector<IndexedNode> _tree_index;
+   bool _tree_index_valid;
+
 };
 
 #endif // GRAPHIC_CONTAINER_H
@@ -1857,23 +1857,30 @@ bool MainWindow::SavedState::operator ==(const MainWindow::SavedState &other) co
     return true;
 }
 
-void MainWindow::resetTreeStyle(AbsBehaviorTree &tree){
-    //printf("resetTreeStyle\n");
-    QtNodes::NodeStyle  node_style;
-    QtNodes::ConnectionStyle conn_style;
+namespace {
 
-    for(auto abs_node: tree.nodes()){
-        auto gui_node = abs_node.graphic_node;
+// the styles of a node that was never executed, shared by all of them
+const StatusStyle& DefaultStatusStyle()
+{
+    static const StatusStyle style = { std::make_shared<const QtNodes::NodeStyle>(),
+                                       std::make_shared<const QtNodes::ConnectionStyle>() };
+    return style;
+}
 
-        gui_node->nodeDataModel()->setNodeStyle( node_style );
-        gui_node->nodeGraphicsObject().update();
+}
+
+void MainWindow::resetTreeStyle(const std::vector<GraphicContainer::IndexedNode> &tree_index)
+{
+    const StatusStyle& style = DefaultStatusStyle();
+
+    for(const auto& indexed: tree_index){
+        indexed.node->nodeDataModel()->setNodeStyle( style.node );
+        indexed.node->nodeGraphicsObject().update();
 
-        const auto& conn_in = gui_node->nodeState().connections(PortType::In, 0 );
-        if(conn_in.size() == 1)
+        if( indexed.input )
         {
-            auto conn = conn_in.begin()->second;
-            conn->setStyle( conn_style );
-            conn->connectionGraphicsObject().update();
+            indexed.input->setStyle( style.connection );
+            indexed.input->connectionGraphicsObject().update();
         }
     }
 }
@@ -1881,38 +1888,54 @@ void MainWindow::resetTreeStyle(AbsBehaviorTree &tree){
 void MainWindow::onChangeNodesStatus(const QString& bt_name,
                                      const std::vector<std::pair<int, NodeStatus> > &node_status)
 {
-    auto tree = BuildTreeFromScene( getTabByName(bt_name)->scene() );
-
-    std::vector<NodeStatus> vec_last_status(tree.nodesCount());
+    auto container = getTabByName(bt_name);
+    if( !container )
+    {
+        return;
+    }
+    // cached by the container: the scene is not visited again
+    const auto& tree_index = container->treeIndex();
 
-    // printf("---\n");
+    if( _last_status.size() < tree_index.size() )
+    {
+        _last_status.resize( tree_index.size(), NodeStatus::IDLE );
+    }
 
     for (auto& it: node_status)
     {
         const int index = it.first;
         const NodeStatus status = it.second;
-        auto& abs_node = tree.nodes().at(index);
-
-        // printf("%3d: %d, %s\n", index, (int)it.second, abs_node.instance_name.toStdString().c_str());
+        if( index < 0 || static_cast<size_t>(index) >= tree_index.size() )
+        {
+            continue;
+        }
 
         if(index == 1 && it.second == NodeStatus::RUNNING)
-            resetTreeStyle(tree);
+            resetTreeStyle(tree_index);
 
-        auto gui_node = abs_node.graphic_node;
-        auto style = getStyleFromStatus( status, vec_last_status[index] );
-        gui_node->nodeDataModel()->setNodeStyle( style.first );
+        auto gui_node = tree_index[index].node;
+        const StatusStyle& style = getSharedStyleFromStatus( status, _last_status[index] );
+        gui_node->nodeDataModel()->setNodeStyle( style.node );
         gui_node->nodeGraphicsObject().update();
 
-        vec_last_status[index] = status;
+        _last_status[index] = status;
 
-        const auto& conn_in = gui_node->nodeState().connections(PortType::In, 0 );
-        if(conn_in.size() == 1)
+        auto conn = tree_index[index].input;
+        if( conn )
         {
-            auto conn = conn_in.begin()->second;
-            conn->setStyle( style.second );
+            conn->setStyle( style.connection );
             conn->connectionGraphicsObject().update();
         }
     }
+
+    // only the nodes changed by this call
+    for (auto& it: node_status)
+    {
+        if( it.first >= 0 && static_cast<size_t>(it.first) < _last_status.size() )
+        {
+            _last_status[it.first] = NodeStatus::IDLE;
+        }
+    }
 }
 
 void MainWindow::onTabCustomContextMenuRequested(const QPoint &pos)
@@ -60,8 +60,6 @@ public:
 
     const NodeModels &registeredModels() const;
 
-    void resetTreeStyle(AbsBehaviorTree &tree);
-
     GraphicMode getGraphicMode(void) const;
 
 public slots:
@@ -145,6 +143,8 @@ public:
 
 private:
 
+    void resetTreeStyle(const std::vector<GraphicContainer::IndexedNode>& tree_index);
+
     void tryLoadWorkspace(const QString& workspace_text, bool overwriteOldWorkspace);
 
     bool documentFromText(QString text, QDomDocument *out);
@@ -219,6 +219,9 @@ private:
     std::deque<SavedState> _undo_stack;
     std::deque<SavedState> _redo_stack;
     SavedState _current_state;
+
+    // used by onChangeNodesStatus(): the status set by the current call, IDLE for the others
+    std::vector<NodeStatus> _last_status;
     QtNodes::PortLayout _current_layout;
 
     NodeModels 
@@ -0,0 +1,353 @@
+#include "monitor_connection.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "utils.h"
+
+MonitorConnection::Statistics::Statistics():
+    elapsed(0),
+    messages(0),
+    transitions(0),
+    queue_max(0)
+{
+}
+
+MonitorConnection::MonitorConnection(zmq::context_t &context, const QString &tree_name,
+                                     QObject *parent):
+    QObject(parent),
+    _context(context),
+    _tree_name(tree_name),
+    _receiver(context),
+    _tree_generation(0),
+    _tree_loaded(false),
+    _msg_count(0),
+    _tree_request_pending(false),
+    _failed_requests(0),
+    _retry_delay_ms(MonitorReceiver::RECONNECT_MIN_MS)
+{
+}
+
+MonitorConnection::~MonitorConnection()
+{
+    close();
+}
+
+bool MonitorConnection::open(const std::string &address_pub, const std::string &address_req)
+{
+    close();
+    _address_pub = address_pub;
+    _address_req = address_req;
+    _error_string.clear();
+    _tree_loaded = false;
+    _msg_count = 0;
+
+    try{
+        // messages are received and decoded by another thread
+        _receiver.start( _address_pub );
+    }
+    catch( zmq::error_t& err)
+    {
+        _error_string = err.what();
+        return false;
+    }
+
+    _stats = Statistics();
+    _stats_clock.start();
+    _last_message_clock.start();
+    requestTree();
+    return true;
+}
+
+void MonitorConnection::close()
+{
+    _receiver.stop();
+    _tree_client.reset();
+    _tree_request_pending = false;
+    stopRecording();
+}
+
+MonitorConnection::State MonitorConnection::state() const
+{
+    if( !_tree_loaded )
+    {
+        return State::WAITING_TREE;
+    }
+    if( _tree_request_pending || _last_message_clock.elapsed() > STALE_TIMEOUT_MS )
+    {
+        return State::STALE;
+    }
+    return State::CONNECTED;
+}
+
+void MonitorConnection::processMessages(bool paint, bool *painted)
+{
+    if( painted )
+    {
+        *painted = false;
+    }
+    if( !isOpen() )
+    {
+        return;
+    }
+    pollTreeRequest();
+
+    // only the messages received so far: the others wait for the next frame
+    size_t pending = _receiver.queueSize();
+    _stats.queue_max = std::max( _stats.queue_max, pending );
+    MonitorMessage message;
+
+    while( pending-- > 0 && _receiver.pop( message ) )
+    {
+        // decoded with the uids of a previous tree
+        if( message.generation != _tree_generation )
+        {
+            continue;
+        }
+        _msg_count++;
+        _last_message_clock.restart();
+
+        // the tree changed: wait for the new one
+        if( _tree_request_pending )
+        {
+            continue;
+        }
+        if( message.result == MonitorMessage::Result::UNKNOWN_UID )
+        {
+            qDebug() << "Reload tree from server" << _tree_name;
+            requestTree();
+            continue;
+        }
+
+        for(size_t index = 0; index < message.tree_status.size(); index++)
+        {
+            _loaded_tree.node( index )->status = message.tree_status[index];
+        }
+        for(const auto& it: message.node_status)
+        {
+            _loaded_tree.node( it.first )->status = it.second;
+            _conflator.add( it.first, it.second );
+        }
+        _stats.messages++;
+        _stats.transitions += message.node_status.size();
+        if( message.timestamp >= 0 )
+        {
+            _frame_timestamps.push_back( message.timestamp );
+        }
+    }
+
+    // while the tab is hidden, the conflator keeps at most one entry per node
+    // and the latency is not measured
+    if( !paint )
+    {
+        _frame_timestamps.clear();
+        return;
+    }
+
+    if( !_conflator.empty() )
+    {
+        // update the graphic part, once per frame
+        _conflator.take( _frame_status );
+        emit changeNodeStyle( _tree_name, _frame_status );
+        if( painted )
+        {
+            *painted = true;
+        }
+    }
+
+    // latency from the robot to the update of the scene, same clock used by the logger
+    const double now = std::chrono::duration<double>(
+                std::chrono::system_clock::now().time_since_epoch() ).count();
+    for (double timestamp: _frame_timestamps)
+    {
+        _stats.latency.add( now - timestamp );
+    }
+    _frame_timestamps.clear();
+}
+
+MonitorConnection::Statistics MonitorConnection::takeStatistics()
+{
+    Statistics stats = std::move(_stats);
+    stats.elapsed = _stats_clock.restart() * 0.001;
+    _stats = Statistics();
+    return stats;
+}
+
+void MonitorConnection::startRecording(const QString &file_name)
+{
+    _record_file_name = file_name;
+    _writer.open( file_name, _tree_header );
+    // written by the receiver thread, until the tree changes
+    _receiver.setWriter( &_writer, _tree_generation );
+}
+
+void MonitorConnection::stopRecording()
+{
+    _receiver.setWriter( nullptr, 0 );
+    if( _writer.isOpen() )
+    {
+        _writer.close();
+    }
+}
+
+void MonitorConnection::requestTree()
+{
+    if( _tree_request_pending )
+    {
+        return;
+    }
+    _tree_request_pending = true;
+    _failed_requests = 0;
+    _retry_delay_ms = MonitorReceiver::RECONNECT_MIN_MS;
+    sendTreeRequest();
+}
+
+void MonitorConnection::sendTreeRequest()
+{
+    try{
+        _tree_client.reset( new zmq::socket_t( _context, ZMQ_REQ ) );
+
+        // an unanswered request is discarded when the socket is closed
+        int linger_ms = 0;
+        _tree_client->setsockopt(ZMQ_LINGER, &linger_ms, sizeof(int) );
+        _tree_client->connect( _address_req.c_str() );
+
+        zmq::message_t request(0);
+        if( !_tree_client->send(request, ZMQ_DONTWAIT) )
+        {
+            treeRequestFailed( tr("can't send the request to [%1]").arg( _address_req.c_str() ) );
+            return;
+        }
+        _tree_request_clock.start();
+    }
+    catch( zmq::error_t& err)
+    {
+        treeRequestFailed( err.what() );
+    }
+}
+
+void MonitorConnection::pollTreeRequest()
+{
+    if( !_tree_request_pending )
+    {
+        return;
+    }
+
+    // waiting for the next attempt
+    if( !_tree_client )
+    {
+        if( _tree_request_clock.elapsed() >= _retry_delay_ms )
+        {
+            _retry_delay_ms = std::min( 2 * _retry_delay_ms, static_cast<int>(MonitorReceiver::RECONNECT_MAX_MS) );
+            sendTreeRequest();
+        }
+        return;
+    }
+
+    zmq::message_t reply;
+    try{
+        if( !_tree_client->recv(&reply, ZMQ_DONTWAIT) )
+        {
+            if( _tree_request_clock.elapsed() > TREE_REQUEST_TIMEOUT_MS )
+            {
+                treeRequestFailed( tr("no reply from [%1]").arg( _address_req.c_str() ) );
+            }
+            return;
+        }
+    }
+    catch( zmq::error_t& err)
+    {
+        treeRequestFailed( err.what() );
+        return;
+    }
+    _tree_client.reset();
+
+    if( !loadTree( reply ) )
+    {
+        treeRequestFailed( _error_string );
+        return;
+    }
+    _tree_loaded = true;
+    _tree_request_pending = false;
+    _failed_requests = 0;
+    _error_string.clear();
+    _last_message_clock.restart();
+}
+
+void MonitorConnection::treeRequestFailed(const QString &error)
+{
+    qDebug() << "Tree request failed:" << error;
+    // a REQ socket can't send again before receiving the reply
+    _tree_client.reset();
+    _error_string = error;
+    _failed_requests++;
+    // the next attempt is after _retry_delay_ms
+    _tree_request_clock.start();
+}
+
+bool MonitorConnection::loadTree(const zmq::message_t &reply)
+{
+    const char* buffer = reinterpret_cast<const char*>(reply.data());
+
+    const uint32_t reply_size = static_cast<uint32_t>( reply.size() );
+    QByteArray header( static_cast<int>( 4 + reply_size ), Qt::Uninitialized );
+    flatbuffers::WriteScalar<uint32_t>( header.data(), reply_size );
+    std::memcpy( header.data() + 4, buffer, reply_size );
+
+    // same header of a .fbl file: verify it and get a dense uid-to-index table.
+    // If it isn't valid, the previous tree and its header are kept
+    size_t transitions_offset = 0;
+    std::vector<int16_t> uid_to_index;
+    if( ParseReplayHeader( header.constData(), static_cast<size_t>( header.size() ),
+                           transitions_offset, uid_to_index ) != ReplayFormatError::NONE )
+    {
+        _error_string = tr("the tree received from the server is not valid");
+        return false;
+    }
+
+    // the uids of the new tree might be different: a log has a single header
+    if( _writer.isOpen() )
+    {
+        emit recordingInterrupted( tr("the tree was reloaded from the server") );
+    }
+    _tree_header = std::move(header);
+
+    auto fb_behavior_tree = Serialization::GetBehaviorTree( _tree_header.constData() + 4 );
+    auto res_pair = BuildTreeFromFlatbuffers( fb_behavior_tree );
+
+    _loaded_tree  = std::move( res_pair.first );
+    _tree_generation = _receiver.setTree( uid_to_index, _loaded_tree.nodesCount() );
+    _conflator.reset( _loaded_tree.nodesCount() );
+    _frame_timestamps.clear();
+
+    // add new models to registry
+    for(const auto& tree_node: _loaded_tree.nodes())
+    {
+        const auto& registration_ID = tree_node.model.registration_ID;
+        if( BuiltinNodeModels().count(registration_ID) == 0)
+        {
+            addNewModel( tree_node.model );
+        }
+    }
+
+    try {
+        loadBehaviorTree( _loaded_tree, _tree_name );
+    }
+    catch (std::exception& err) {
+        _error_string = err.what();
+        return false;
+    }
+
+    std::vector<std::pair<int, NodeStatus>> node_status;
+    node_status.reserve(_loaded_tree.nodesCount());
+
+    for(size_t t=0; t < _loaded_tree.nodesCount(); t++)
+    {
+        node_status.push_back( { t, _loaded_tree.nodes()[t].status } );
+    }
+    emit changeNodeStyle( _tree_name, node_status );
+    return true;
+}
@@ -0,0 +1,180 @@
+#ifndef MONITOR_CONNECTION_H
+#define MONITOR_CONNECTION_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <memory>
+#include <zmq.hpp>
+
+#include "bt_editor_base.h"
+#include "replay_writer.h"
+#include "monitor_receiver.h"
+#include "status_conflator.h"
+#include "replay_statistics.h"
+
+/**
+ * The connection to a single robot: its receiver thread, the tree loaded
+ * from its server and the state needed to draw and record its transitions.
+ *
+ * SidepanelMonitor keeps one of these per robot. They share the same
+ * zmq::context_t and are driven by the same timer, so that each robot costs
+ * at most one update of its scene per frame, and none while its tab is hidden.
+ *
+ * Nothing blocks on the network: the tree is requested to the server with a
+ * non-blocking REQ socket, polled every frame. If the request fails, it is
+ * repeated with an exponential backoff. The publisher is reconnected by ZMQ,
+ * with the same backoff (see SetReconnectBackoff()).
+ */
+class MonitorConnection : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    enum class State{
+        // the tree was never received from the server
+        WAITING_TREE,
+        CONNECTED,
+        // the tree shown might not be the one running: it is being reloaded,
+        // or no message was received for STALE_TIMEOUT_MS
+        STALE
+    };
+
+    static const int TREE_REQUEST_TIMEOUT_MS = 1000;
+    static const int STALE_TIMEOUT_MS = 3000;
+
+    // counted since the last call of takeStatistics()
+    struct Statistics{
+        Statistics();
+        double elapsed;
+        size_t messages;
+        size_t transitions;
+        size_t queue_max;
+        // from the timestamp of the last transition of a message to the update of the scene
+        DurationHistogram latency;
+    };
+
+    MonitorConnection(zmq::context_t& context, const QString& tree_name, QObject* parent = nullptr);
+
+    ~MonitorConnection();
+
+    // name of the tab where the tree is drawn
+    const QString& treeName() const { return _tree_name; }
+
+    const std::string& publisherAddress() const { return _address_pub; }
+
+    // Connect to the publisher and request the tree to the server.
+    // Fails only if the addresses are not valid. Doesn't throw.
+    bool open(const std::string& address_pub, const std::string& address_req);
+
+    void close();
+
+    bool isOpen() const { return _receiver.isRunning(); }
+
+    State state() const;
+
+    // true while the tree is requested again, because the robot changed it
+    bool isReloadingTree() const { return _tree_loaded && _tree_request_pending; }
+
+    // consecutive requests of the tree that failed
+    int failedRequests() const { return _failed_requests; }
+
+    // milliseconds since the last message, or since the tree was loaded
+    qint64 silenceTime() const { return _last_message_clock.elapsed(); }
+
+    // why the last request of the tree failed
+    const QString& errorString() const { return _error_string; }
+
+    // Poll the request of the tree, if any, and consume the messages received
+    // so far. If paint is false, the transitions are merged with the ones of
+    // the following frames instead of being drawn.
+    void processMessages(bool paint, bool* painted = nullptr);
+
+    // the messages received since open()
+    int messagesCount() const { return _msg_count; }
+
+    size_t queueSize() const { return _receiver.queueSize(); }
+
+    size_t droppedMessages() const { return _receiver.droppedMessages(); }
+
+    size_t malformedMessages() const { return _receiver.malformedMessages(); }
+
+    size_t conflatedCount() const { return _conflator.conflatedCount(); }
+
+    Statistics takeStatistics();
+
+    // Every transition decoded with the current tree is recorded by the
+    // receiver thread, including the messages not drawn. The only losses are
+    // the ones of the writer (see ReplayLogWriter::droppedRecords()).
+    void startRecording(const QString& file_name);
+
+    // waits for the pending transitions to be written
+    void stopRecording();
+
+    const ReplayLogWriter& writer() const { return _writer; }
+
+    const QString& recordFileName() const { return _record_file_name; }
+
+signals:
+    void loadBehaviorTree(const AbsBehaviorTree& tree, const QString &bt_name );
+
+    void changeNodeStyle(const QString& bt_name,
+                         const std::vector<std::pair<int, NodeStatus>>& node_status);
+
+    void addNewModel(const NodeModel &new_model);
+
+    // the recording must be stopped, because the tree changed
+    void recordingInterrupted(const QString& reason);
+
+private:
+
+    // send the request, or schedule it if the previous one failed
+    void requestTree();
+
+    void sendTreeRequest();
+
+    void pollTreeRequest();
+
+    void treeRequestFailed(const QString& error);
+
+    bool loadTree(const zmq::message_t& reply);
+
+    zmq::context_t& _context;
+    QString _tree_name;
+    std::string _address_pub;
+    std::string _address_req;
+    QString _error_string;
+
+    MonitorReceiver _receiver;
+    // messages decoded with a different tree are discarded
+    unsigned _tree_generation;
+    AbsBehaviorTree _loaded_tree;
+    bool _tree_loaded;
+    int _msg_count;
+    QElapsedTimer _last_message_clock;
+
+    // the tree is requested until a valid reply is received
+    bool _tree_request_pending;
+    std::unique_ptr<zmq::socket_t> _tree_client;
+    QElapsedTimer _tree_request_clock;
+    int _failed_requests;
+    int _retry_delay_ms;
+
+    // as in a .fbl file: size of the flatbuffer, then the flatbuffer
+    QByteArray _tree_header;
+
+    // all the messages of a frame become a single update of the scene
+    StatusConflator _conflator;
+    std::vector<std::pair<int, NodeStatus>> _frame_status;
+    std::vector<double> _frame_timestamps;
+
+    QElapsedTimer _stats_clock;
+    Statistics _stats;
+
+    ReplayLogWriter _writer;
+    QString _record_file_name;
+};
+
+#endif // MONITOR_CONNECTION_H
@@ -0,0 +1,207 @@
+#include "monitor_receiver.h"
+
+#include <QDebug>
+
+#include "utils.h"
+
+MonitorMessage::MonitorMessage():
+    generation(0),
+    result(Result::OK),
+    timestamp(-1)
+{
+}
+
+MonitorMessage::Result DecodeMonitorMessage(const char* buffer, size_t size,
+                                            const std::vector<int16_t>& uid_to_index,
+                                            size_t nodes_count,
+                                            MonitorMessage& message)
+{
+    message.tree_status.assign( nodes_count, NodeStatus::IDLE );
+    message.node_status.clear();
+    message.records.clear();
+    message.timestamp = -1;
+
+    // size of the header and number of transitions
+    if( size < 8 )
+    {
+        return message.result = MonitorMessage::Result::MALFORMED;
+    }
+    const size_t header_size = flatbuffers::ReadScalar<uint32_t>( buffer );
+    if( header_size % 3 != 0 || header_size > size - 8 )
+    {
+        return message.result = MonitorMessage::Result::MALFORMED;
+    }
+    const size_t transitions_offset = 8 + header_size;
+    const size_t num_transitions = flatbuffers::ReadScalar<uint32_t>( &buffer[4 + header_size] );
+    if( num_transitions > (size - transitions_offset) / REPLAY_RECORD_SIZE )
+    {
+        return message.result = MonitorMessage::Result::MALFORMED;
+    }
+
+    for(size_t offset = 4; offset < header_size + 4; offset += 3 )
+    {
+        const uint16_t uid = flatbuffers::ReadScalar<uint16_t>( &buffer[offset] );
+        const int16_t index = (uid < uid_to_index.size()) ? uid_to_index[uid] : -1;
+        if( index < 0 || static_cast<size_t>(index) >= nodes_count )
+        {
+            return message.result = MonitorMessage::Result::UNKNOWN_UID;
+        }
+        message.tree_status[index] =
+                convert( flatbuffers::ReadScalar<Serialization::NodeStatus>( &buffer[offset+2] ) );
+    }
+
+    message.node_status.reserve( num_transitions );
+    ReplayRecord record;
+    for(size_t t = 0; t < num_transitions; t++)
+    {
+        const char* data = &buffer[transitions_offset + REPLAY_RECORD_SIZE * t];
+        if( !DecodeReplayRecord( data, uid_to_index, record ) ||
+            static_cast<size_t>(record.index) >= nodes_count )
+        {
+            return message.result = MonitorMessage::Result::UNKNOWN_UID;
+        }
+        message.node_status.push_back( { record.index, record.status } );
+        message.timestamp = record.timestamp();
+    }
+
+    message.records = QByteArray( &buffer[transitions_offset],
+                                  static_cast<int>(REPLAY_RECORD_SIZE * num_transitions) );
+    return message.result = MonitorMessage::Result::OK;
+}
+
+void SetReconnectBackoff(zmq::socket_t &socket)
+{
+    // the interval doubles after every failed attempt, up to the maximum
+    int reconnect_ms = MonitorReceiver::RECONNECT_MIN_MS;
+    int reconnect_max_ms = MonitorReceiver::RECONNECT_MAX_MS;
+    socket.setsockopt(ZMQ_RECONNECT_IVL, &reconnect_ms, sizeof(int) );
+    socket.setsockopt(ZMQ_RECONNECT_IVL_MAX, &reconnect_max_ms, sizeof(int) );
+}
+
+MonitorReceiver::MonitorReceiver(zmq::context_t &context):
+    _context(context),
+    _stop(false),
+    _queue(QUEUE_CAPACITY),
+    _dropped_messages(0),
+    _malformed_messages(0),
+    _generation(0),
+    _writer(nullptr),
+    _writer_generation(0)
+{
+}
+
+MonitorReceiver::~MonitorReceiver()
+{
+    stop();
+}
+
+void MonitorReceiver::start(const std::string &address)
+{
+    stop();
+
+    _subscriber.reset( new zmq::socket_t( _context, ZMQ_SUB ) );
+    _subscriber->connect( address.c_str() );
+
+    // wake up periodically, to check if the thread must stop
+    int timeout_ms = 50;
+    _subscriber->setsockopt(ZMQ_SUBSCRIBE, "", 0);
+    _subscriber->setsockopt(ZMQ_RCVTIMEO,&timeout_ms, sizeof(int) );
+    SetReconnectBackoff( *_subscriber );
+
+    _stop = false;
+    _dropped_messages = 0;
+    _malformed_messages = 0;
+    // from now on, the socket is used only by the thread
+    _thread = std::thread( &MonitorReceiver::loop, this );
+}
+
+void MonitorReceiver::stop()
+{
+    if( _thread.joinable() )
+    {
+        _stop = true;
+        _thread.join();
+    }
+    _subscriber.reset();
+
+    MonitorMessage message;
+    while( _queue.pop(message) ) {}
+}
+
+unsigned MonitorReceiver::setTree(const std::vector<int16_t> &uid_to_index, size_t nodes_count)
+{
+    auto tree = std::make_shared<TreeIndex>();
+    tree->uid_to_index = uid_to_index;
+    tree->nodes_count = nodes_count;
+
+    std::lock_guard<std::mutex> lock(_tree_mutex);
+    _tree = tree;
+    return ++_generation;
+}
+
+void MonitorReceiver::setWriter(ReplayLogWriter *writer, unsigned generation)
+{
+    std::lock_guard<std::mutex> lock(_writer_mutex);
+    _writer = writer;
+    _writer_generation = generation;
+}
+
+void MonitorReceiver::loop()
+{
+    std::shared_ptr<const TreeIndex> tree;
+    unsigned generation = 0;
+
+    while( !_stop )
+    {
+        zmq::message_t msg;
+        try{
+            if( !_subscriber->recv(&msg) )
+            {
+                continue;
+            }
+        }
+        catch( zmq::error_t& err)
+        {
+            qDebug() << "ZMQ receive failed: " << err.what();
+            continue;
+        }
+
+        // the lock is taken only when the tree changes
+        if( generation != _generation )
+        {
+            std::lock_guard<std::mutex> lock(_tree_mutex);
+            tree = _tree;
+            generation = _generation;
+        }
+        if( !tree )
+        {
+            continue;
+        }
+
+        MonitorMessage message;
+        message.generation = generation;
+        if( DecodeMonitorMessage( reinterpret_cast<const char*>(msg.data()), msg.size(),
+                                  tree->uid_to_index, tree->nodes_count,
+                                  message ) == MonitorMessage::Result::MALFORMED )
+        {
+            _malformed_messages++;
+            continue;
+        }
+
+        // recorded even if the message is dropped, or discarded by the GUI thread
+        if( message.result == MonitorMessage::Result::OK && !message.records.isEmpty() )
+        {
+            std::lock_guard<std::mutex> lock(_writer_mutex);
+            if( _writer && _writer_generation == generation )
+            {
+                _writer->append( message.records.constData(),
+                                 static_cast<size_t>( message.records.size() ) / REPLAY_RECORD_SIZE );
+            }
+        }
+
+        if( !_queue.push( std::move(message) ) )
+        {
+            _dropped_messages++;
+        }
+    }
+}
@@ -0,0 +1,137 @@
+#ifndef MONITOR_RECEIVER_H
+#define MONITOR_RECEIVER_H
+
+#include <QByteArray>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <zmq.hpp>
+
+#include "bt_editor_base.h"
+#include "replay_format.h"
+#include "replay_writer.h"
+#include "spsc_queue.h"
+
+/**
+ * A message of the ZMQ publisher (PublisherZMQ), decoded. The message is:
+ *
+ *     uint32 size of the header | 3 bytes per node (uid, status) |
+ *     uint32 number of transitions | 12 bytes per transition, as in a .fbl file
+ */
+struct MonitorMessage
+{
+    enum class Result{ OK, UNKNOWN_UID, MALFORMED };
+
+    MonitorMessage();
+
+    // see MonitorReceiver::setTree()
+    unsigned generation;
+
+    // UNKNOWN_UID if the tree must be reloaded from the server
+    Result result;
+
+    // status of all the nodes, by index, as sent in the header of the message
+    std::vector<NodeStatus> tree_status;
+
+    // the transitions, in order
+    std::vector<std::pair<int, NodeStatus>> node_status;
+
+    // timestamp of the last transition, negative if there are none
+    double timestamp;
+
+    // the transitions as they are stored in a .fbl file
+    QByteArray records;
+};
+
+// Single pass, every read is checked against the size of the message.
+// uid_to_index is dense, as filled by ParseReplayHeader(). Doesn't throw.
+MonitorMessage::Result DecodeMonitorMessage(const char* buffer, size_t size,
+                                            const std::vector<int16_t>& uid_to_index,
+                                            size_t nodes_count,
+                                            MonitorMessage& message);
+
+// Reconnect with an exponential backoff, from RECONNECT_MIN_MS to RECONNECT_MAX_MS.
+void SetReconnectBackoff(zmq::socket_t& socket);
+
+/**
+ * Receives and decodes the messages of the publisher on its own thread.
+ * The GUI thread consumes them with pop(), at its own pace.
+ *
+ * The transitions are recorded by this thread, before the message is queued:
+ * a recording doesn't lose the messages dropped because the queue is full,
+ * nor the ones that the GUI thread discards.
+ */
+class MonitorReceiver
+{
+public:
+
+    static const size_t QUEUE_CAPACITY = 1024;
+
+    // exponential backoff of the reconnection to the publisher
+    static const int RECONNECT_MIN_MS = 250;
+    static const int RECONNECT_MAX_MS = 8000;
+
+    explicit MonitorReceiver(zmq::context_t& context);
+
+    ~MonitorReceiver();
+
+    // Connect to the publisher and start the thread.
+    // Throws zmq::error_t if the address is not valid.
+    void start(const std::string& address);
+
+    void stop();
+
+    bool isRunning() const { return _thread.joinable(); }
+
+    // Set the uids of the tree loaded from the server (see ParseReplayHeader()).
+    // Messages decoded with a previous tree have a lower generation.
+    // Returns the new generation.
+    unsigned setTree(const std::vector<int16_t>& uid_to_index, size_t nodes_count);
+
+    // Append the transitions of the messages decoded with the tree of the
+    // given generation to writer, until it is set to nullptr.
+    // The writer must stay open while it is set.
+    void setWriter(ReplayLogWriter* writer, unsigned generation);
+
+    // consumer side of the queue
+    bool pop(MonitorMessage& message) { return _queue.pop(message); }
+
+    size_t queueSize() const { return _queue.size(); }
+
+    // messages that didn't fit into the queue
+    size_t droppedMessages() const { return _dropped_messages; }
+
+    // messages discarded because their content is not valid
+    size_t malformedMessages() const { return _malformed_messages; }
+
+private:
+
+    void loop();
+
+    zmq::context_t& _context;
+    std::unique_ptr<zmq::socket_t> _subscriber;
+    std::thread _thread;
+    std::atomic<bool> _stop;
+
+    SPSCQueue<MonitorMessage> _queue;
+    std::atomic<size_t> _dropped_messages;
+    std::atomic<size_t> _malformed_messages;
+
+    struct TreeIndex{
+        std::vector<int16_t> uid_to_index;
+        size_t nodes_count;
+    };
+
+    std::mutex _tree_mutex;
+    std::shared_ptr<const TreeIndex> _tree;
+    std::atomic<unsigned> _generation;
+
+    // the lock is never contended for long: it is taken by the thread for each append
+    std::mutex _writer_mutex;
+    ReplayLogWriter* _writer;
+    unsigned _writer_generation;
+};
+
+#endif // MONITOR_RECEIVER_H
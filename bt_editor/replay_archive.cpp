@@ -0,0 +1,426 @@
+#include "replay_archive.h"
+
+#include <QDataStream>
+#include <QtEndian>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace {
+
+// offset of the index and magic number
+const qint64 FOOTER_SIZE = 8 + 4;
+
+const ReplayNodeState IDLE_STATE = { BT::NodeStatus::IDLE, BT::NodeStatus::IDLE };
+
+void applyRecord(const ReplayRecord& record, std::vector<ReplayNodeState>& state)
+{
+    auto& node_state = state[ record.index ];
+    node_state.prev_status = node_state.status;
+    node_state.status = record.status;
+}
+
+}
+
+bool IsReplayArchive(const char *data, size_t size)
+{
+    return size >= 4 && std::memcmp( data, REPLAY_ARCHIVE_MAGIC, 4 ) == 0;
+}
+
+//------------------------------------------------------------
+
+ReplayArchiveWriter::ReplayArchiveWriter(size_t chunk_records):
+    _chunk_records( std::max<size_t>(1, chunk_records) ),
+    _nodes_count(0),
+    _rows(0)
+{
+}
+
+ReplayArchiveWriter::~ReplayArchiveWriter()
+{
+    if( _file.isOpen() )
+    {
+        close();
+    }
+}
+
+bool ReplayArchiveWriter::open(const QString &file_name, const QByteArray &header)
+{
+    size_t transitions_offset = 0;
+    if( ParseReplayHeader( header.constData(), static_cast<size_t>( header.size() ),
+                           transitions_offset, _uid_to_index ) != ReplayFormatError::NONE )
+    {
+        _error_string = "The header is not a valid BehaviorTree";
+        return false;
+    }
+    _nodes_count = Serialization::GetBehaviorTree( &header.constData()[4] )->nodes()->size() + 1;
+
+    _file.setFileName(file_name);
+    if( !_file.open(QIODevice::WriteOnly | QIODevice::Truncate) )
+    {
+        _error_string = _file.errorString();
+        return false;
+    }
+
+    QDataStream stream(&_file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.writeRawData( REPLAY_ARCHIVE_MAGIC, 4 );
+    stream << quint32(REPLAY_ARCHIVE_VERSION);
+    stream.writeRawData( header.constData(), static_cast<int>(transitions_offset) );
+
+    _rows = 0;
+    _index.clear();
+    _chunk.clear();
+    // with a reserved capacity, resize(0) doesn't release the memory
+    _chunk.reserve( static_cast<int>( _chunk_records * REPLAY_RECORD_SIZE ) );
+    _restart_detector = ReplayRestartDetector( _nodes_count );
+    _state.assign( _nodes_count, IDLE_STATE );
+
+    if( stream.status() != QDataStream::Ok )
+    {
+        _error_string = _file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool ReplayArchiveWriter::append(const char *record)
+{
+    ReplayRecord decoded;
+    if( !DecodeReplayRecord( record, _uid_to_index, decoded ) )
+    {
+        _error_string = QString("Unknown node uid in transition %1").arg(_rows);
+        return false;
+    }
+
+    if( _chunk.isEmpty() )
+    {
+        _current.first_row = _rows;
+        _current.first_usec = decoded.timestampUsec();
+        _current.idle_counter = _restart_detector.idleCounter();
+        _current.snapshot.resize( _nodes_count );
+        for (size_t index = 0; index < _nodes_count; index++)
+        {
+            _current.snapshot[index] = PackReplayNodeState( _state[index] );
+        }
+    }
+
+    if( _restart_detector.update( decoded ) )
+    {
+        std::fill( _state.begin(), _state.end(), IDLE_STATE );
+    }
+    applyRecord( decoded, _state );
+    _current.last_usec = decoded.timestampUsec();
+
+    _chunk.append( record, static_cast<int>(REPLAY_RECORD_SIZE) );
+    _rows++;
+
+    if( static_cast<size_t>( _chunk.size() ) >= _chunk_records * REPLAY_RECORD_SIZE )
+    {
+        return writeChunk();
+    }
+    return true;
+}
+
+bool ReplayArchiveWriter::writeChunk()
+{
+    const QByteArray compressed = qCompress( _chunk );
+
+    _current.offset = static_cast<uint64_t>( _file.pos() );
+    _current.compressed_size = static_cast<uint32_t>( compressed.size() );
+    _current.records = static_cast<uint32_t>( _chunk.size() / REPLAY_RECORD_SIZE );
+
+    QDataStream stream(&_file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream << quint32( _current.compressed_size );
+    stream.writeRawData( compressed.constData(), compressed.size() );
+
+    _index.push_back( _current );
+    // keep the capacity, the next chunk has the same size
+    _chunk.resize(0);
+
+    if( stream.status() != QDataStream::Ok )
+    {
+        _error_string = _file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool ReplayArchiveWriter::close()
+{
+    if( !_file.isOpen() )
+    {
+        return false;
+    }
+    bool ok = true;
+    if( !_chunk.isEmpty() )
+    {
+        ok = writeChunk();
+    }
+
+    const quint64 index_offset = static_cast<quint64>( _file.pos() );
+
+    QDataStream stream(&_file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream << quint32( _index.size() ) << quint32( _nodes_count );
+    for (const auto& chunk: _index)
+    {
+        stream << quint64( chunk.offset ) << quint32( chunk.compressed_size )
+               << quint64( chunk.first_row ) << quint32( chunk.records )
+               << quint64( chunk.first_usec ) << quint64( chunk.last_usec )
+               << qint32( chunk.idle_counter );
+        stream.writeRawData( reinterpret_cast<const char*>( chunk.snapshot.data() ),
+                             static_cast<int>( chunk.snapshot.size() ) );
+    }
+    stream << index_offset;
+    stream.writeRawData( REPLAY_ARCHIVE_MAGIC, 4 );
+
+    if( stream.status() != QDataStream::Ok )
+    {
+        _error_string = _file.errorString();
+        ok = false;
+    }
+    _file.close();
+    return ok;
+}
+
+//------------------------------------------------------------
+
+ReplayArchive::ReplayArchive():
+    _nodes_count(0),
+    _records_count(0)
+{
+}
+
+bool ReplayArchive::open(const QString &file_name)
+{
+    _file.setFileName(file_name);
+    if( !_file.open(QIODevice::ReadOnly) )
+    {
+        _error_string = _file.errorString();
+        return false;
+    }
+    const qint64 file_size = _file.size();
+
+    QDataStream stream(&_file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    char magic[4];
+    quint32 version = 0;
+    quint32 bt_header_size = 0;
+    stream.readRawData( magic, 4 );
+    stream >> version >> bt_header_size;
+
+    if( stream.status() != QDataStream::Ok || !IsReplayArchive( magic, 4 ) )
+    {
+        _error_string = "Not a Groot archive";
+        return false;
+    }
+    if( version > REPLAY_ARCHIVE_VERSION )
+    {
+        _error_string = QString("Unsupported archive version %1").arg(version);
+        return false;
+    }
+    if( bt_header_size == 0 || qint64(bt_header_size) > file_size - 12 - FOOTER_SIZE )
+    {
+        _error_string = "The header is corrupted";
+        return false;
+    }
+
+    _header.resize( static_cast<int>(4 + bt_header_size) );
+    flatbuffers::WriteScalar<uint32_t>( _header.data(), bt_header_size );
+    stream.readRawData( _header.data() + 4, static_cast<int>(bt_header_size) );
+
+    size_t transitions_offset = 0;
+    if( stream.status() != QDataStream::Ok ||
+        ParseReplayHeader( _header.constData(), static_cast<size_t>( _header.size() ),
+                           transitions_offset, _uid_to_index ) != ReplayFormatError::NONE )
+    {
+        _error_string = "The header is not a valid BehaviorTree";
+        return false;
+    }
+    _nodes_count = behaviorTree()->nodes()->size() + 1;
+
+    _file.seek( file_size - FOOTER_SIZE );
+    quint64 index_offset = 0;
+    stream >> index_offset;
+    stream.readRawData( magic, 4 );
+
+    const qint64 data_start = 12 + bt_header_size;
+    if( stream.status() != QDataStream::Ok || !IsReplayArchive( magic, 4 ) ||
+        index_offset < quint64(data_start) || index_offset > quint64(file_size - FOOTER_SIZE) )
+    {
+        _error_string = "The archive is truncated: the index is missing";
+        return false;
+    }
+    return readIndex( static_cast<qint64>(index_offset), file_size - FOOTER_SIZE );
+}
+
+bool ReplayArchive::readIndex(qint64 index_offset, qint64 index_end)
+{
+    _file.seek( index_offset );
+    QDataStream stream(&_file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 chunks_count = 0;
+    quint32 nodes_count = 0;
+    stream >> chunks_count >> nodes_count;
+
+    // each entry is at least 44 bytes: don't trust chunks_count blindly
+    const qint64 entry_size = 44 + nodes_count;
+    if( stream.status() != QDataStream::Ok || nodes_count != _nodes_count ||
+        qint64(chunks_count) * entry_size > index_end - index_offset )
+    {
+        _error_string = "The index of the archive is corrupted";
+        return false;
+    }
+
+    _chunks.clear();
+    _chunks.reserve( chunks_count );
+    _records_count = 0;
+
+    for (quint32 i = 0; i < chunks_count; i++)
+    {
+        ReplayArchiveChunk chunk;
+        quint64 offset, first_row, first_usec, last_usec;
+        quint32 compressed_size, records;
+        qint32 idle_counter;
+        stream >> offset >> compressed_size >> first_row >> records
+               >> first_usec >> last_usec >> idle_counter;
+        chunk.offset = offset;
+        chunk.compressed_size = compressed_size;
+        chunk.first_row = first_row;
+        chunk.records = records;
+        chunk.first_usec = first_usec;
+        chunk.last_usec = last_usec;
+        chunk.idle_counter = idle_counter;
+        chunk.snapshot.resize( nodes_count );
+        stream.readRawData( reinterpret_cast<char*>( chunk.snapshot.data() ),
+                            static_cast<int>(nodes_count) );
+
+        if( stream.status() != QDataStream::Ok ||
+            first_row != _records_count || records == 0 ||
+            records > INT_MAX / REPLAY_RECORD_SIZE ||
+            offset + 4 + compressed_size > quint64(index_offset) )
+        {
+            _error_string = "The index of the archive is corrupted";
+            _chunks.clear();
+            return false;
+        }
+        _records_count += records;
+        _chunks.push_back( std::move(chunk) );
+    }
+    return true;
+}
+
+const Serialization::BehaviorTree *ReplayArchive::behaviorTree() const
+{
+    return Serialization::GetBehaviorTree( &_header.constData()[4] );
+}
+
+size_t ReplayArchive::chunkAt(double time) const
+{
+    auto it = std::upper_bound( _chunks.begin(), _chunks.end(), time,
+                                [](double val, const ReplayArchiveChunk& chunk) -> bool
+    {
+        return val < ReplayTimestamp( chunk.first_usec );
+    } );
+    if( it == _chunks.begin() )
+    {
+        return _chunks.size();
+    }
+    return static_cast<size_t>( (it - 1) - _chunks.begin() );
+}
+
+size_t ReplayArchive::chunkOfRow(size_t row) const
+{
+    auto it = std::upper_bound( _chunks.begin(), _chunks.end(), row,
+                                [](size_t val, const ReplayArchiveChunk& chunk) -> bool
+    {
+        return val < chunk.first_row;
+    } );
+    return it == _chunks.begin() ? 0 : static_cast<size_t>( (it - 1) - _chunks.begin() );
+}
+
+bool ReplayArchive::readChunk(size_t chunk, QByteArray &records)
+{
+    const auto& info = _chunks[chunk];
+    if( !_file.seek( static_cast<qint64>(info.offset) ) )
+    {
+        _error_string = _file.errorString();
+        return false;
+    }
+    QDataStream stream(&_file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 compressed_size = 0;
+    stream >> compressed_size;
+    QByteArray compressed( static_cast<int>(info.compressed_size), Qt::Uninitialized );
+    stream.readRawData( compressed.data(), compressed.size() );
+
+    if( stream.status() != QDataStream::Ok || compressed_size != info.compressed_size )
+    {
+        _error_string = QString("Can't read chunk %1").arg(chunk);
+        return false;
+    }
+    // qCompress stores the uncompressed size first: check it before allocating
+    const size_t expected_size = info.records * REPLAY_RECORD_SIZE;
+    if( compressed.size() < 4 ||
+        qFromBigEndian<quint32>( reinterpret_cast<const uchar*>( compressed.constData() ) ) != expected_size )
+    {
+        _error_string = QString("Chunk %1 is corrupted").arg(chunk);
+        return false;
+    }
+    records = qUncompress( compressed );
+    if( static_cast<size_t>( records.size() ) != expected_size )
+    {
+        _error_string = QString("Chunk %1 is corrupted").arg(chunk);
+        return false;
+    }
+    return true;
+}
+
+bool ReplayArchive::stateAt(double time, std::vector<ReplayNodeState> &state)
+{
+    state.assign( _nodes_count, IDLE_STATE );
+
+    const size_t chunk = chunkAt(time);
+    if( chunk >= _chunks.size() )
+    {
+        return true;
+    }
+    const auto& info = _chunks[chunk];
+    for (size_t index = 0; index < _nodes_count; index++)
+    {
+        state[index] = UnpackReplayNodeState( info.snapshot[index] );
+    }
+
+    QByteArray records;
+    if( !readChunk( chunk, records ) )
+    {
+        return false;
+    }
+    ReplayRestartDetector restart_detector( _nodes_count, info.idle_counter );
+    ReplayRecord record;
+
+    for (size_t i = 0; i < info.records; i++)
+    {
+        if( !DecodeReplayRecord( records.constData() + i * REPLAY_RECORD_SIZE,
+                                 _uid_to_index, record ) )
+        {
+            _error_string = QString("Chunk %1 is corrupted").arg(chunk);
+            return false;
+        }
+        if( record.timestamp() > time )
+        {
+            break;
+        }
+        if( restart_detector.update( record ) )
+        {
+            std::fill( state.begin(), state.end(), IDLE_STATE );
+        }
+        applyRecord( record, state );
+    }
+    return true;
+}
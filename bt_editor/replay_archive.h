@@ -0,0 +1,146 @@
+#ifndef REPLAY_ARCHIVE_H
+#define REPLAY_ARCHIVE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <vector>
+
+#include "replay_format.h"
+
+/*
+ * Chunked and compressed variant of the .fbl format, to archive long runs:
+ *
+ *     "GRBZ" | uint32 version | .fbl header | chunk | chunk | ... |
+ *     index | uint64 offset of the index | "GRBZ"
+ *
+ * The .fbl header is the same of a plain log (size and flatbuffer).
+ * Each chunk is a block of up to chunkRecords() 12 bytes long records,
+ * compressed with qCompress (zlib) and prefixed by its uint32 size.
+ * The index has, for each chunk, its position in the file, the range of rows
+ * and timestamps it contains and a snapshot of the state of the tree before
+ * its first record. All the integers are little endian.
+ */
+
+const char REPLAY_ARCHIVE_MAGIC[4] = { 'G', 'R', 'B', 'Z' };
+const uint32_t REPLAY_ARCHIVE_VERSION = 1;
+
+// True if the data starts like an archive rather than a plain .fbl log.
+bool IsReplayArchive(const char* data, size_t size);
+
+struct ReplayArchiveChunk
+{
+    uint64_t offset;
+    uint32_t compressed_size;
+    uint64_t first_row;
+    uint32_t records;
+    uint64_t first_usec;
+    uint64_t last_usec;
+    // see ReplayRestartDetector::idleCounter()
+    int32_t idle_counter;
+    // one PackReplayNodeState() per node, before the first record.
+    // The state is reset to IDLE every time the tree is restarted.
+    std::vector<uint8_t> snapshot;
+};
+
+/**
+ * Writes an archive, one record at a time. Memory is bounded by one chunk
+ * and by the index (a few bytes per node for each chunk).
+ */
+class ReplayArchiveWriter
+{
+public:
+
+    static const size_t DEFAULT_CHUNK_RECORDS = 16*1024;
+
+    explicit ReplayArchiveWriter(size_t chunk_records = DEFAULT_CHUNK_RECORDS);
+
+    ~ReplayArchiveWriter();
+
+    // header as in a .fbl file: 4 bytes with the size of the flatbuffer, then the flatbuffer
+    bool open(const QString& file_name, const QByteArray& header);
+
+    // a 12 bytes long record, as in a .fbl file
+    bool append(const char* record);
+
+    // write the last chunk and the index
+    bool close();
+
+    QString errorString() const { return _error_string; }
+
+private:
+
+    bool writeChunk();
+
+    QFile _file;
+    QString _error_string;
+    size_t _chunk_records;
+
+    std::vector<int16_t> _uid_to_index;
+    size_t _nodes_count;
+
+    QByteArray _chunk;
+    ReplayArchiveChunk _current;
+    std::vector<ReplayArchiveChunk> _index;
+
+    uint64_t _rows;
+    ReplayRestartDetector _restart_detector;
+    std::vector<ReplayNodeState> _state;
+};
+
+/**
+ * Random access to an archive: only the index is read by open(), chunks are
+ * read and decompressed on demand. Seeking to a time touches a single chunk.
+ */
+class ReplayArchive
+{
+public:
+
+    ReplayArchive();
+
+    bool open(const QString& file_name);
+
+    QString errorString() const { return _error_string; }
+
+    // as in a .fbl file: 4 bytes with the size of the flatbuffer, then the flatbuffer
+    const QByteArray& header() const { return _header; }
+
+    const Serialization::BehaviorTree* behaviorTree() const;
+
+    const std::vector<int16_t>& uidToIndex() const { return _uid_to_index; }
+
+    // Number of nodes, including the "Root" added by BuildTreeFromFlatbuffers.
+    size_t nodesCount() const { return _nodes_count; }
+
+    size_t recordsCount() const { return _records_count; }
+
+    const std::vector<ReplayArchiveChunk>& chunks() const { return _chunks; }
+
+    // Last chunk whose first timestamp is <= time, or chunks().size()
+    // if the time is before the first record.
+    size_t chunkAt(double time) const;
+
+    // chunk that contains the row, with a binary search
+    size_t chunkOfRow(size_t row) const;
+
+    // Decompressed records of the chunk, 12 bytes each.
+    bool readChunk(size_t chunk, QByteArray& records);
+
+    // State of all the nodes after the last record with timestamp <= time.
+    // Reads only the chunk that contains it.
+    bool stateAt(double time, std::vector<ReplayNodeState>& state);
+
+private:
+
+    bool readIndex(qint64 index_offset, qint64 index_end);
+
+    QFile _file;
+    QString _error_string;
+    QByteArray _header;
+    std::vector<int16_t> _uid_to_index;
+    size_t _nodes_count;
+    size_t _records_count;
+    std::vector<ReplayArchiveChunk> _chunks;
+};
+
+#endif // REPLAY_ARCHIVE_H
@@ -0,0 +1,97 @@
+#include "replay_compare_dialog.h"
+#include "ui_replay_compare_dialog.h"
+
+#include <algorithm>
+#include <QHeaderView>
+
+ReplayCompareDialog::ReplayCompareDialog(std::shared_ptr<const ReplayLog> log_a,
+                                         const AbsBehaviorTree &tree_a, const QString &name_a,
+                                         std::shared_ptr<const ReplayLog> log_b,
+                                         const AbsBehaviorTree &tree_b, const QString &name_b,
+                                         const ReplayDiff &diff,
+                                         QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::ReplayCompareDialog),
+    _log_a(log_a),
+    _log_b(log_b),
+    _diff(diff)
+{
+    ui->setupUi(this);
+
+    _model_a = new ReplayTableModel(this);
+    _model_a->setLog( _log_a, tree_a );
+    _model_b = new ReplayTableModel(this);
+    _model_b->setLog( _log_b, tree_b );
+
+    ui->tableViewA->setModel( _model_a );
+    ui->tableViewB->setModel( _model_b );
+
+    for (QTableView* view: { ui->tableViewA, ui->tableViewB })
+    {
+        view->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+        view->horizontalHeader()->setSectionResizeMode(ReplayTableModel::NODE_NAME, QHeaderView::Stretch);
+    }
+
+    ui->labelA->setText( name_a );
+    ui->labelB->setText( name_b );
+
+    QString summary;
+    if( !_diff.diverged )
+    {
+        summary = tr("The sequences of statuses are identical (%1 ticks).")
+                      .arg( _diff.ticks_compared );
+    }
+    else{
+        summary = tr("First divergence at tick %1. %2 of %3 ticks are different.")
+                      .arg( _diff.tick ).arg( _diff.ticks_diverging ).arg( _diff.ticks_compared );
+
+        _model_a->setMarkedRow( static_cast<int>(_diff.row_a) );
+        _model_b->setMarkedRow( static_cast<int>(_diff.row_b) );
+    }
+    if( _diff.unmatched_nodes > 0 )
+    {
+        summary += tr(" %1 nodes of the second log don't match any node of the first one.")
+                       .arg( _diff.unmatched_nodes );
+    }
+    ui->labelSummary->setText( summary );
+    ui->pushButtonDivergence->setEnabled( _diff.diverged );
+
+    on_pushButtonDivergence_clicked();
+}
+
+ReplayCompareDialog::~ReplayCompareDialog()
+{
+    delete ui;
+}
+
+void ReplayCompareDialog::on_pushButtonDivergence_clicked()
+{
+    if( _diff.diverged )
+    {
+        showRow( ui->tableViewA, _diff.row_a );
+        showRow( ui->tableViewB, _diff.row_b );
+    }
+}
+
+void ReplayCompareDialog::on_tableViewA_clicked(const QModelIndex &index)
+{
+    showRow( ui->tableViewB, AlignedReplayRow( *_log_a, *_log_b, index.row() ) );
+}
+
+void ReplayCompareDialog::on_tableViewB_clicked(const QModelIndex &index)
+{
+    showRow( ui->tableViewA, AlignedReplayRow( *_log_b, *_log_a, index.row() ) );
+}
+
+void ReplayCompareDialog::showRow(QTableView *view, size_t row)
+{
+    // the row is past the end when a log ended before the other one
+    const int last_row = view->model()->rowCount() - 1;
+    const int visible_row = std::min( static_cast<int>(row), last_row );
+    if( visible_row < 0 )
+    {
+        return;
+    }
+    view->selectRow( visible_row );
+    view->scrollTo( view->model()->index( visible_row, 0 ), QAbstractItemView::PositionAtCenter );
+}
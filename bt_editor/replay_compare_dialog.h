@@ -0,0 +1,58 @@
+#ifndef REPLAY_COMPARE_DIALOG_H
+#define REPLAY_COMPARE_DIALOG_H
+
+#include <memory>
+#include <QDialog>
+#include <QTableView>
+
+#include "bt_editor_base.h"
+#include "replay_diff.h"
+#include "replay_table_model.h"
+
+namespace Ui {
+class ReplayCompareDialog;
+}
+
+/**
+ * Two logs of the same tree side by side, with the first divergence
+ * (see CompareReplayLogs) highlighted. Selecting a row selects the row at the
+ * same position of the other log.
+ */
+class ReplayCompareDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    ReplayCompareDialog(std::shared_ptr<const ReplayLog> log_a,
+                        const AbsBehaviorTree& tree_a, const QString& name_a,
+                        std::shared_ptr<const ReplayLog> log_b,
+                        const AbsBehaviorTree& tree_b, const QString& name_b,
+                        const ReplayDiff& diff,
+                        QWidget *parent = nullptr);
+
+    ~ReplayCompareDialog() override;
+
+private slots:
+
+    void on_pushButtonDivergence_clicked();
+
+    void on_tableViewA_clicked(const QModelIndex &index);
+
+    void on_tableViewB_clicked(const QModelIndex &index);
+
+private:
+
+    void showRow(QTableView* view, size_t row);
+
+    Ui::ReplayCompareDialog *ui;
+
+    std::shared_ptr<const ReplayLog> _log_a;
+    std::shared_ptr<const ReplayLog> _log_b;
+
+    ReplayTableModel* _model_a;
+    ReplayTableModel* _model_b;
+
+    ReplayDiff _diff;
+};
+
+#endif // REPLAY_COMPARE_DIALOG_H
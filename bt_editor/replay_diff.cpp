@@ -0,0 +1,120 @@
+#include "replay_diff.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+ReplayDiff::ReplayDiff():
+    unmatched_nodes(0),
+    ticks_compared(0),
+    ticks_diverging(0),
+    diverged(false),
+    tick(0),
+    row_a(0),
+    row_b(0)
+{
+}
+
+std::vector<int16_t> MatchReplayNodes(const ReplayLog &a, const ReplayLog &b)
+{
+    const auto fb_nodes_a = a.behaviorTree()->nodes();
+    const auto fb_nodes_b = b.behaviorTree()->nodes();
+
+    std::unordered_map<uint16_t, flatbuffers::uoffset_t> uid_to_position;
+    for (flatbuffers::uoffset_t i = 0; i < fb_nodes_a->size(); i++)
+    {
+        uid_to_position.insert( { fb_nodes_a->Get(i)->uid(), i } );
+    }
+
+    // index 0 is the Root added by BuildTreeFromFlatbuffers
+    std::vector<int16_t> b_to_a( b.nodesCount(), -1 );
+    b_to_a[0] = 0;
+
+    for (flatbuffers::uoffset_t i = 0; i < fb_nodes_b->size(); i++)
+    {
+        const auto fb_node_b = fb_nodes_b->Get(i);
+        auto it = uid_to_position.find( fb_node_b->uid() );
+        if( it == uid_to_position.end() )
+        {
+            continue;
+        }
+        const auto fb_node_a = fb_nodes_a->Get( it->second );
+        if( std::strcmp( fb_node_a->instance_name()->c_str(),
+                         fb_node_b->instance_name()->c_str() ) == 0 &&
+            std::strcmp( fb_node_a->registration_name()->c_str(),
+                         fb_node_b->registration_name()->c_str() ) == 0 )
+        {
+            b_to_a[i + 1] = static_cast<int16_t>( it->second + 1 );
+        }
+    }
+    return b_to_a;
+}
+
+ReplayDiff CompareReplayLogs(const ReplayLog &a, const ReplayLog &b)
+{
+    ReplayDiff diff;
+    const std::vector<int16_t> b_to_a = MatchReplayNodes(a, b);
+    diff.unmatched_nodes = std::count( b_to_a.begin(), b_to_a.end(), -1 );
+
+    const size_t ticks_a = a.ticksCount();
+    const size_t ticks_b = b.ticksCount();
+    diff.ticks_compared = std::max( ticks_a, ticks_b );
+
+    auto setDivergence = [&diff](size_t tick, size_t row_a, size_t row_b)
+    {
+        diff.ticks_diverging++;
+        if( !diff.diverged )
+        {
+            diff.diverged = true;
+            diff.tick  = tick;
+            diff.row_a = row_a;
+            diff.row_b = row_b;
+        }
+    };
+
+    for (size_t tick = 0; tick < std::min( ticks_a, ticks_b ); tick++)
+    {
+        size_t row_a = a.tickStart(tick);
+        size_t row_b = b.tickStart(tick);
+        const size_t end_a = a.tickEnd(tick);
+        const size_t end_b = b.tickEnd(tick);
+
+        while( row_a < end_a && row_b < end_b &&
+               b_to_a[ b.nodeIndex(row_b) ] == a.nodeIndex(row_a) &&
+               b.status(row_b) == a.status(row_a) )
+        {
+            row_a++;
+            row_b++;
+        }
+        if( row_a < end_a || row_b < end_b )
+        {
+            setDivergence( tick, row_a, row_b );
+        }
+    }
+
+    // one of the two runs has more ticks
+    if( ticks_a != ticks_b )
+    {
+        const size_t tick = std::min( ticks_a, ticks_b );
+        setDivergence( tick,
+                       tick < ticks_a ? a.tickStart(tick) : a.transitionsCount(),
+                       tick < ticks_b ? b.tickStart(tick) : b.transitionsCount() );
+        diff.ticks_diverging += std::max( ticks_a, ticks_b ) - tick - 1;
+    }
+    return diff;
+}
+
+size_t AlignedReplayRow(const ReplayLog &from, const ReplayLog &to, size_t row)
+{
+    if( to.transitionsCount() == 0 || from.transitionsCount() == 0 )
+    {
+        return 0;
+    }
+    const size_t tick = from.tickAt(row);
+    if( tick >= to.ticksCount() )
+    {
+        return to.transitionsCount() - 1;
+    }
+    const size_t offset = row - from.tickStart(tick);
+    return std::min( to.tickStart(tick) + offset, to.tickEnd(tick) - 1 );
+}
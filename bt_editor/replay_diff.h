@@ -0,0 +1,42 @@
+#ifndef REPLAY_DIFF_H
+#define REPLAY_DIFF_H
+
+#include <vector>
+
+#include "replay_log.h"
+
+/**
+ * Comparison of two logs of the same tree. The runs are aligned tick by tick
+ * (i.e. using ReplayLog::restarts()) and, inside a tick, transition by transition.
+ * Only the sequence of nodes and statuses is compared, not the timestamps.
+ */
+struct ReplayDiff
+{
+    ReplayDiff();
+
+    // nodes of the second log without a counterpart in the first one
+    size_t unmatched_nodes;
+
+    size_t ticks_compared;
+    size_t ticks_diverging;
+
+    // first divergence, valid only if diverged is true.
+    // A row equal to transitionsCount() means that the log ended first.
+    bool diverged;
+    size_t tick;
+    size_t row_a;
+    size_t row_b;
+};
+
+// Index in log "a" of each node of log "b", -1 if there is no node with the
+// same uid, instance name and registration name (see BuildTreeFromFlatbuffers).
+std::vector<int16_t> MatchReplayNodes(const ReplayLog& a, const ReplayLog& b);
+
+// Single pass over both logs, no memory allocated per transition.
+ReplayDiff CompareReplayLogs(const ReplayLog& a, const ReplayLog& b);
+
+// Row of "to" at the same position (tick and offset inside the tick)
+// of the given row of "from".
+size_t AlignedReplayRow(const ReplayLog& from, const ReplayLog& to, size_t row);
+
+#endif // REPLAY_DIFF_H
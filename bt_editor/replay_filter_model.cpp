@@ -0,0 +1,369 @@
+#include "replay_filter_model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <QStringList>
+
+ReplayFilterModel::Filter::Filter():
+    time_min( std::numeric_limits<double>::lowest() ),
+    time_max( std::numeric_limits<double>::max() )
+{
+}
+
+bool ReplayFilterModel::Filter::isEmpty() const
+{
+    return name.isEmpty() && types.empty() && statuses.empty() &&
+           time_min == std::numeric_limits<double>::lowest() &&
+           time_max == std::numeric_limits<double>::max();
+}
+
+ReplayFilterModel::Filter ReplayFilterModel::parseFilter(const QString &text)
+{
+    const NodeStatus ALL_STATUSES[] = { NodeStatus::IDLE, NodeStatus::RUNNING,
+                                        NodeStatus::SUCCESS, NodeStatus::FAILURE };
+    const NodeType ALL_TYPES[] = { NodeType::ACTION, NodeType::CONDITION, NodeType::CONTROL,
+                                   NodeType::DECORATOR, NodeType::SUBTREE };
+    Filter filter;
+    QStringList name_words;
+
+    for (const QString& word: text.split(' ', QString::SkipEmptyParts))
+    {
+        const int colon = word.indexOf(':');
+        const QString key   = word.left(colon).toLower();
+        const QString value = word.mid(colon + 1);
+
+        if( colon > 0 && key == "status" )
+        {
+            const size_t prev_size = filter.statuses.size();
+            for (NodeStatus status: ALL_STATUSES)
+            {
+                if( !value.isEmpty() &&
+                    QString::fromStdString(toStr(status)).startsWith(value, Qt::CaseInsensitive) )
+                {
+                    filter.statuses.push_back(status);
+                }
+            }
+            if( value.isEmpty() || filter.statuses.size() > prev_size ) continue;
+        }
+        else if( colon > 0 && key == "type" )
+        {
+            const size_t prev_size = filter.types.size();
+            for (NodeType type: ALL_TYPES)
+            {
+                if( !value.isEmpty() &&
+                    QString::fromStdString(toStr(type)).startsWith(value, Qt::CaseInsensitive) )
+                {
+                    filter.types.push_back(type);
+                }
+            }
+            if( value.isEmpty() || filter.types.size() > prev_size ) continue;
+        }
+        else if( colon > 0 && key == "time" )
+        {
+            // "time:START-END", both are optional
+            const QStringList range = value.split('-');
+            bool ok = false;
+            double t = range[0].toDouble(&ok);
+            if( ok ) filter.time_min = t;
+
+            if( range.size() > 1 )
+            {
+                t = range[1].toDouble(&ok);
+                if( ok ) filter.time_max = t;
+            }
+            continue;
+        }
+        name_words.push_back(word);
+    }
+    filter.name = name_words.join(' ');
+    return filter;
+}
+
+ReplayFilterModel::ReplayFilterModel(QObject *parent) :
+    QAbstractProxyModel(parent),
+    _filtered(false)
+{
+}
+
+void ReplayFilterModel::setSourceModel(QAbstractItemModel *source_model)
+{
+    if( sourceModel() )
+    {
+        disconnect( sourceModel(), nullptr, this, nullptr );
+    }
+    beginResetModel();
+    QAbstractProxyModel::setSourceModel(source_model);
+    endResetModel();
+
+    connect( source_model, &QAbstractItemModel::modelAboutToBeReset,
+             this, &ReplayFilterModel::beginResetModel );
+
+    connect( source_model, &QAbstractItemModel::modelReset,
+             this, &ReplayFilterModel::endResetModel );
+
+    connect( source_model, &QAbstractItemModel::rowsAboutToBeInserted,
+             this, &ReplayFilterModel::onSourceRowsAboutToBeInserted );
+
+    connect( source_model, &QAbstractItemModel::rowsInserted,
+             this, &ReplayFilterModel::onSourceRowsInserted );
+
+    connect( source_model, &QAbstractItemModel::dataChanged,
+             this, &ReplayFilterModel::onSourceDataChanged );
+}
+
+void ReplayFilterModel::setLog(std::shared_ptr<const ReplayLog> log, const AbsBehaviorTree &tree)
+{
+    _log = log;
+    _node_names.clear();
+    _node_types.clear();
+    for (const auto& node: tree.nodes())
+    {
+        _node_names.push_back( node.instance_name );
+        _node_types.push_back( node.model.type );
+    }
+    updateRows();
+}
+
+void ReplayFilterModel::setFilter(const Filter &filter)
+{
+    _filter = filter;
+    updateRows();
+}
+
+bool ReplayFilterModel::acceptsNode(size_t index) const
+{
+    if( !_filter.name.isEmpty() &&
+        !_node_names[index].contains(_filter.name, Qt::CaseInsensitive) )
+    {
+        return false;
+    }
+    return _filter.types.empty() ||
+           std::find( _filter.types.begin(), _filter.types.end(),
+                      _node_types[index] ) != _filter.types.end();
+}
+
+bool ReplayFilterModel::acceptsRow(size_t row) const
+{
+    const double t = _log->timestamp(row) - _log->timestamp(0);
+    if( t < _filter.time_min || t > _filter.time_max )
+    {
+        return false;
+    }
+    if( !_filter.statuses.empty() &&
+        std::find( _filter.statuses.begin(), _filter.statuses.end(),
+                   _log->status(row) ) == _filter.statuses.end() )
+    {
+        return false;
+    }
+    return acceptsNode( _log->nodeIndex(row) );
+}
+
+void ReplayFilterModel::updateRows()
+{
+    beginResetModel();
+
+    _rows.clear();
+    _filtered = _log && !_filter.isEmpty();
+
+    if( _filtered && _log->transitionsCount() > 0 )
+    {
+        // time window, with binary search
+        const double first_timestamp = _log->timestamp(0);
+        size_t first_row = 0;
+        size_t end_row = _log->transitionsCount();
+
+        if( _filter.time_min != std::numeric_limits<double>::lowest() )
+        {
+            first_row = _log->lowerBoundRow( first_timestamp + _filter.time_min );
+        }
+        if( _filter.time_max != std::numeric_limits<double>::max() )
+        {
+            end_row = _log->lowerBoundRow( std::nextafter( first_timestamp + _filter.time_max,
+                                                           std::numeric_limits<double>::max() ) );
+        }
+
+        // posting lists of the nodes that match the filter
+        struct Cursor{
+            const uint32_t* it;
+            const uint32_t* end;
+        };
+        std::vector<Cursor> cursors;
+        size_t total_rows = 0;
+
+        for (size_t index = 0; index < _node_names.size(); index++)
+        {
+            if( !acceptsNode(index) )
+            {
+                continue;
+            }
+            const auto& node_rows = _log->nodeRows(index);
+            auto first = std::lower_bound( node_rows.begin(), node_rows.end(), first_row );
+            auto last  = std::lower_bound( first, node_rows.end(), end_row );
+            if( first != last )
+            {
+                const uint32_t* data = node_rows.data();
+                cursors.push_back( { data + (first - node_rows.begin()),
+                                     data + (last - node_rows.begin()) } );
+                total_rows += (last - first);
+            }
+        }
+
+        // k-way merge of the posting lists, to keep the rows sorted
+        typedef std::pair<uint32_t, size_t> Head;
+        std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+        for (size_t i = 0; i < cursors.size(); i++)
+        {
+            heads.push( { *cursors[i].it, i } );
+        }
+
+        _rows.reserve( _filter.statuses.empty() ? total_rows : 0 );
+
+        while( !heads.empty() )
+        {
+            const Head head = heads.top();
+            heads.pop();
+
+            if( _filter.statuses.empty() ||
+                std::find( _filter.statuses.begin(), _filter.statuses.end(),
+                           _log->status(head.first) ) != _filter.statuses.end() )
+            {
+                _rows.push_back( head.first );
+            }
+
+            auto& cursor = cursors[head.second];
+            if( ++cursor.it != cursor.end )
+            {
+                heads.push( { *cursor.it, head.second } );
+            }
+        }
+    }
+
+    endResetModel();
+}
+
+QModelIndex ReplayFilterModel::mapToSource(const QModelIndex &proxy_index) const
+{
+    if( !proxy_index.isValid() || !sourceModel() )
+    {
+        return QModelIndex();
+    }
+    const int row = _filtered ? static_cast<int>( _rows[proxy_index.row()] ) : proxy_index.row();
+    return sourceModel()->index( row, proxy_index.column() );
+}
+
+QModelIndex ReplayFilterModel::mapFromSource(const QModelIndex &source_index) const
+{
+    if( !source_index.isValid() )
+    {
+        return QModelIndex();
+    }
+    if( !_filtered )
+    {
+        return index( source_index.row(), source_index.column() );
+    }
+    const uint32_t source_row = static_cast<uint32_t>( source_index.row() );
+    auto it = std::lower_bound( _rows.begin(), _rows.end(), source_row );
+    if( it == _rows.end() || *it != source_row )
+    {
+        return QModelIndex();
+    }
+    return index( static_cast<int>(it - _rows.begin()), source_index.column() );
+}
+
+QModelIndex ReplayFilterModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if( parent.isValid() || row < 0 || row >= rowCount() ||
+        column < 0 || column >= columnCount() )
+    {
+        return QModelIndex();
+    }
+    return createIndex( row, column );
+}
+
+QModelIndex ReplayFilterModel::parent(const QModelIndex &) const
+{
+    return QModelIndex();
+}
+
+int ReplayFilterModel::rowCount(const QModelIndex &parent) const
+{
+    if( parent.isValid() || !sourceModel() )
+    {
+        return 0;
+    }
+    return _filtered ? static_cast<int>( _rows.size() ) : sourceModel()->rowCount();
+}
+
+int ReplayFilterModel::columnCount(const QModelIndex &parent) const
+{
+    if( parent.isValid() || !sourceModel() )
+    {
+        return 0;
+    }
+    return sourceModel()->columnCount();
+}
+
+QVariant ReplayFilterModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if( orientation == Qt::Horizontal && sourceModel() )
+    {
+        return sourceModel()->headerData(section, orientation, role);
+    }
+    return QAbstractProxyModel::headerData(section, orientation, role);
+}
+
+void ReplayFilterModel::onSourceRowsAboutToBeInserted(const QModelIndex &, int first, int last)
+{
+    if( !_filtered )
+    {
+        beginInsertRows( QModelIndex(), first, last );
+    }
+}
+
+void ReplayFilterModel::onSourceRowsInserted(const QModelIndex &, int first, int last)
+{
+    if( !_filtered )
+    {
+        endInsertRows();
+        return;
+    }
+
+    std::vector<uint32_t> new_rows;
+    for (int row = first; row <= last; row++)
+    {
+        if( acceptsRow(row) )
+        {
+            new_rows.push_back( static_cast<uint32_t>(row) );
+        }
+    }
+    if( !new_rows.empty() )
+    {
+        const int count = static_cast<int>( _rows.size() );
+        beginInsertRows( QModelIndex(), count, count + static_cast<int>(new_rows.size()) - 1 );
+        _rows.insert( _rows.end(), new_rows.begin(), new_rows.end() );
+        endInsertRows();
+    }
+}
+
+void ReplayFilterModel::onSourceDataChanged(const QModelIndex &top_left,
+                                            const QModelIndex &bottom_right,
+                                            const QVector<int> &roles)
+{
+    if( !_filtered )
+    {
+        emit dataChanged( mapFromSource(top_left), mapFromSource(bottom_right), roles );
+        return;
+    }
+    auto first = std::lower_bound( _rows.begin(), _rows.end(),
+                                   static_cast<uint32_t>( top_left.row() ) );
+    auto last  = std::upper_bound( first, _rows.end(),
+                                   static_cast<uint32_t>( bottom_right.row() ) );
+    if( first != last )
+    {
+        emit dataChanged( index( static_cast<int>(first - _rows.begin()), top_left.column() ),
+                          index( static_cast<int>(last - _rows.begin()) - 1, bottom_right.column() ),
+                          roles );
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef REPLAY_FILTER_MODEL_H
+#define REPLAY_FILTER_MODEL_H
+
+#include <memory>
+#include <QAbstractProxyModel>
+
+#include "bt_editor_base.h"
+#include "replay_log.h"
+
+/**
+ * Proxy of ReplayTableModel that shows only the transitions accepted by a Filter.
+ *
+ * The rows are not scanned one by one: the visible rows are the union of the
+ * posting lists (ReplayLog::nodeRows) of the nodes that match the filter,
+ * restricted to the time window with a binary search.
+ */
+class ReplayFilterModel : public QAbstractProxyModel
+{
+    Q_OBJECT
+
+public:
+
+    struct Filter{
+        Filter();
+
+        // case insensitive, part of the instance name
+        QString name;
+        // empty means "any"
+        std::vector<NodeType> types;
+        std::vector<NodeStatus> statuses;
+        // seconds, relative to the first transition
+        double time_min;
+        double time_max;
+
+        bool isEmpty() const;
+    };
+
+    // Words in the form "status:FAILURE", "type:Action" or "time:1.5-3" are
+    // structured filters, the remaining text is part of the node name.
+    static Filter parseFilter(const QString& text);
+
+    explicit ReplayFilterModel(QObject *parent = nullptr);
+
+    void setSourceModel(QAbstractItemModel *source_model) override;
+
+    void setLog(std::shared_ptr<const ReplayLog> log, const AbsBehaviorTree& tree);
+
+    void setFilter(const Filter& filter);
+
+    QModelIndex mapToSource(const QModelIndex &proxy_index) const override;
+
+    QModelIndex mapFromSource(const QModelIndex &source_index) const override;
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+
+    QModelIndex parent(const QModelIndex &child) const override;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+private slots:
+
+    void onSourceRowsAboutToBeInserted(const QModelIndex &parent, int first, int last);
+
+    void onSourceRowsInserted(const QModelIndex &parent, int first, int last);
+
+    void onSourceDataChanged(const QModelIndex &top_left, const QModelIndex &bottom_right,
+                             const QVector<int> &roles);
+
+private:
+
+    bool acceptsNode(size_t index) const;
+
+    bool acceptsRow(size_t row) const;
+
+    void updateRows();
+
+    std::shared_ptr<const ReplayLog> _log;
+    std::vector<QString> _node_names;
+    std::vector<NodeType> _node_types;
+
+    Filter _filter;
+    bool _filtered;
+
+    // source rows, sorted. Used only if _filtered is true
+    std::vector<uint32_t> _rows;
+};
+
+#endif // REPLAY_FILTER_MODEL_H
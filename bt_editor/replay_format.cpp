@@ -0,0 +1,103 @@
+#include "replay_format.h"
+
+namespace {
+
+BT::NodeStatus convertStatus(Serialization::NodeStatus status)
+{
+    switch (status)
+    {
+    case Serialization::NodeStatus::IDLE:    return BT::NodeStatus::IDLE;
+    case Serialization::NodeStatus::SUCCESS: return BT::NodeStatus::SUCCESS;
+    case Serialization::NodeStatus::RUNNING: return BT::NodeStatus::RUNNING;
+    case Serialization::NodeStatus::FAILURE: return BT::NodeStatus::FAILURE;
+    }
+    return BT::NodeStatus::IDLE;
+}
+
+}
+
+ReplayFormatError ParseReplayHeader(const char *data, size_t size,
+                                    size_t &transitions_offset,
+                                    std::vector<int16_t> &uid_to_index)
+{
+    // we need at least 4 bytes to read the bt_header_size
+    if( size < 4 ) {
+        return ReplayFormatError::EMPTY;
+    }
+
+    // read the length of the header section from the file
+    const size_t bt_header_size = flatbuffers::ReadScalar<uint32_t>(data);
+
+    // if the length of the header goes past the end of the file, it is invalid
+    if( (bt_header_size == 0) || (bt_header_size > size - 4) ) {
+        return ReplayFormatError::CORRUPTED;
+    }
+
+    flatbuffers::Verifier verifier( reinterpret_cast<const uint8_t*>(data + 4),
+                                    bt_header_size );
+
+    if( ! Serialization::VerifyBehaviorTreeBuffer(verifier) )
+    {
+        return ReplayFormatError::INVALID_FORMAT;
+    }
+
+    transitions_offset = 4 + bt_header_size;
+
+    // same indexing used by BuildTreeFromFlatbuffers: index 0 is the Root
+    const auto fb_nodes = Serialization::GetBehaviorTree( &data[4] )->nodes();
+    uid_to_index.clear();
+
+    for(flatbuffers::uoffset_t i = 0; i < fb_nodes->size(); i++ )
+    {
+        const uint16_t uid = fb_nodes->Get(i)->uid();
+        if( uid >= uid_to_index.size() )
+        {
+            uid_to_index.resize( uid + 1, -1 );
+        }
+        uid_to_index[uid] = static_cast<int16_t>(i + 1);
+    }
+    return ReplayFormatError::NONE;
+}
+
+bool DecodeReplayRecord(const char *data, const std::vector<int16_t> &uid_to_index,
+                        ReplayRecord &record)
+{
+    const uint16_t uid = flatbuffers::ReadScalar<uint16_t>( &data[8] );
+    record.index = (uid < uid_to_index.size()) ? uid_to_index[uid] : -1;
+    if( record.index < 0 )
+    {
+        return false;
+    }
+    record.sec  = flatbuffers::ReadScalar<uint32_t>( &data[0] );
+    record.usec = flatbuffers::ReadScalar<uint32_t>( &data[4] );
+    record.prev_status = convertStatus( flatbuffers::ReadScalar<Serialization::NodeStatus>( &data[10] ) );
+    record.status      = convertStatus( flatbuffers::ReadScalar<Serialization::NodeStatus>( &data[11] ) );
+    return true;
+}
+
+ReplayRestartDetector::ReplayRestartDetector(size_t nodes_count):
+    _total_nodes( static_cast<int>(nodes_count) ),
+    _idle_counter( static_cast<int>(nodes_count) )
+{
+}
+
+ReplayRestartDetector::ReplayRestartDetector(size_t nodes_count, int idle_counter):
+    _total_nodes( static_cast<int>(nodes_count) ),
+    _idle_counter( idle_counter )
+{
+}
+
+bool ReplayRestartDetector::update(const ReplayRecord &record)
+{
+    const bool restart = (record.index == 1 &&
+                          (record.status == BT::NodeStatus::RUNNING ||
+                           record.status == BT::NodeStatus::IDLE) &&
+                          _idle_counter >= _total_nodes - 1);
+
+    if(record.prev_status != BT::NodeStatus::IDLE && record.status == BT::NodeStatus::IDLE)
+        _idle_counter++;
+    else if(record.prev_status == BT::NodeStatus::IDLE && record.status != BT::NodeStatus::IDLE)
+        _idle_counter--;
+
+    return restart;
+}
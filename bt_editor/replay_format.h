@@ -0,0 +1,104 @@
+#ifndef REPLAY_FORMAT_H
+#define REPLAY_FORMAT_H
+
+#include <cstdint>
+#include <vector>
+
+#include <behaviortree_cpp_v3/basic_types.h>
+#include <behaviortree_cpp_v3/flatbuffers/BT_logger_generated.h>
+
+/*
+ * Decoding of the .fbl format, shared by ReplayLog and by the tools that read
+ * a log sequentially. It depends only on BehaviorTree.CPP, not on Qt.
+ *
+ * The file is: 4 bytes with the size of the header, the flatbuffer header
+ * (Serialization::BehaviorTree) and a stream of 12 bytes long records.
+ */
+
+enum class ReplayFormatError{ NONE, EMPTY, CORRUPTED, INVALID_FORMAT };
+
+const size_t REPLAY_RECORD_SIZE = 12;
+
+// Status of a node and the one it had before the last transition.
+struct ReplayNodeState
+{
+    BT::NodeStatus status;
+    BT::NodeStatus prev_status;
+};
+
+// Both statuses in one byte: status in the low nibble.
+inline uint8_t PackReplayNodeState(const ReplayNodeState& state)
+{
+    return static_cast<uint8_t>(state.status) |
+           static_cast<uint8_t>( static_cast<uint8_t>(state.prev_status) << 4 );
+}
+
+inline ReplayNodeState UnpackReplayNodeState(uint8_t packed)
+{
+    return { static_cast<BT::NodeStatus>(packed & 0x0F),
+             static_cast<BT::NodeStatus>(packed >> 4) };
+}
+
+// Same rounding of "sec + usec * 0.000001", as written by the logger.
+inline double ReplayTimestamp(uint64_t usec)
+{
+    const double t_sec  = static_cast<double>( usec / 1000000 );
+    const double t_usec = static_cast<double>( usec % 1000000 );
+    return t_sec + t_usec* 0.000001;
+}
+
+struct ReplayRecord
+{
+    uint32_t sec;
+    uint32_t usec;
+    // index of the node, as in BuildTreeFromFlatbuffers (0 is the Root)
+    int16_t index;
+    BT::NodeStatus prev_status;
+    BT::NodeStatus status;
+
+    uint64_t timestampUsec() const { return uint64_t(sec) * 1000000 + usec; }
+
+    double timestamp() const
+    {
+        const double t_sec  = sec;
+        const double t_usec = usec;
+        return t_sec + t_usec* 0.000001;
+    }
+};
+
+// Verify the header at the beginning of "data". On success, transitions_offset
+// is where the first record starts and uid_to_index is a dense table from the
+// uid of a node to its index (-1 if the uid is not part of the tree).
+ReplayFormatError ParseReplayHeader(const char* data, size_t size,
+                                    size_t& transitions_offset,
+                                    std::vector<int16_t>& uid_to_index);
+
+// Returns false if the uid of the node is unknown.
+bool DecodeReplayRecord(const char* data, const std::vector<int16_t>& uid_to_index,
+                        ReplayRecord& record);
+
+/**
+ * The log has no explicit tick boundaries. A tick starts when the first node
+ * of the tree leaves IDLE and all the others are IDLE.
+ */
+class ReplayRestartDetector
+{
+public:
+    explicit ReplayRestartDetector(size_t nodes_count = 0);
+
+    // resume the detection, see idleCounter()
+    ReplayRestartDetector(size_t nodes_count, int idle_counter);
+
+    // To be called for each record, in order.
+    // Returns true if the tree was restarted by this one.
+    bool update(const ReplayRecord& record);
+
+    // state of the detection, to be stored with a snapshot of the tree
+    int idleCounter() const { return _idle_counter; }
+
+private:
+    int _total_nodes;
+    int _idle_counter;
+};
+
+#endif // REPLAY_FORMAT_H
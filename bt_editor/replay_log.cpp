@@ -0,0 +1,476 @@
+#include "replay_log.h"
+#include <algorithm>
+
+namespace {
+
+const ReplayLog::NodeState IDLE_STATE = { NodeStatus::IDLE, NodeStatus::IDLE };
+
+const size_t TIME_BLOCK_SIZE = 256;
+const uint32_t TIME_OVERFLOW = 0xFFFFFFFF;
+
+}
+
+ReplayLog::ReplayLog():
+    _is_archive(false),
+    _data(nullptr),
+    _size(0),
+    _error(Error::NONE),
+    _transitions_offset(0),
+    _records_count(0),
+    _nodes_count(0),
+    _checkpoint_interval(DEFAULT_CHECKPOINT_INTERVAL),
+    _indexed_count(0),
+    _previous_timepoint(0),
+    _last_timepoint_forced(false)
+{
+}
+
+bool ReplayLog::openFile(const QString &file_name)
+{
+    _file.setFileName(file_name);
+
+    if (!_file.open(QIODevice::ReadOnly)){
+        _error = Error::CANT_OPEN;
+        return false;
+    }
+    _size = static_cast<size_t>( _file.size() );
+
+    // we need at least 4 bytes to read the bt_header_size
+    if( _size < 4 ) {
+        _error = Error::EMPTY;
+        return false;
+    }
+
+    const uchar* mapped = _file.map( 0, _file.size() );
+    if( !mapped ) {
+        _error = Error::CANT_OPEN;
+        return false;
+    }
+    _data = reinterpret_cast<const char*>(mapped);
+
+    if( IsReplayArchive( _data, _size ) )
+    {
+        _file.unmap( const_cast<uchar*>( reinterpret_cast<const uchar*>(_data) ) );
+        _file.close();
+        _is_archive = true;
+        return openArchive();
+    }
+    return parseHeader();
+}
+
+bool ReplayLog::openArchive()
+{
+    _stream.reset( new ReplayStream );
+    if( !_stream->open( _file.fileName() ) )
+    {
+        _error = Error::CORRUPTED;
+        return false;
+    }
+    _buffer = _stream->header();
+    _data = _buffer.constData();
+    _size = static_cast<size_t>( _buffer.size() );
+
+    if( !parseHeader() )
+    {
+        return false;
+    }
+    _records_count = _stream->recordsCount();
+    return true;
+}
+
+bool ReplayLog::openBuffer(const QByteArray &content)
+{
+    // QByteArray is implicitly shared: this doesn't copy the content
+    _buffer = content;
+    _data = _buffer.constData();
+    _size = static_cast<size_t>( _buffer.size() );
+
+    if( _size < 4 ) {
+        _error = Error::EMPTY;
+        return false;
+    }
+    return parseHeader();
+}
+
+bool ReplayLog::parseHeader()
+{
+    switch( ParseReplayHeader( _data, _size, _transitions_offset, _uid_to_index ) )
+    {
+    case ReplayFormatError::NONE: break;
+    case ReplayFormatError::EMPTY:          _error = Error::EMPTY;          return false;
+    case ReplayFormatError::CORRUPTED:      _error = Error::CORRUPTED;      return false;
+    case ReplayFormatError::INVALID_FORMAT: _error = Error::INVALID_FORMAT; return false;
+    }
+
+    _records_count = (_size - _transitions_offset) / TRANSITION_SIZE;
+    _nodes_count = behaviorTree()->nodes()->size() + 1;
+
+    _error = Error::NONE;
+    return true;
+}
+
+const Serialization::BehaviorTree *ReplayLog::behaviorTree() const
+{
+    return Serialization::GetBehaviorTree( &_data[4] );
+}
+
+bool ReplayLog::buildIndex(const ProgressCallback& progress, size_t checkpoint_interval)
+{
+    _restarts.clear();
+    _timepoints.clear();
+    _checkpoints.clear();
+    _node_rows.assign( _nodes_count, std::vector<uint32_t>() );
+
+    _time_offsets.clear();
+    _time_blocks.clear();
+    _time_overflows.clear();
+    _node_indices.clear();
+    _statuses.clear();
+    _time_offsets.reserve( _records_count );
+    _node_indices.reserve( _records_count );
+    _statuses.reserve( _records_count );
+
+    _checkpoint_interval = std::max<size_t>(1, checkpoint_interval);
+
+    _indexed_count = 0;
+    _restart_detector = ReplayRestartDetector( _nodes_count );
+    _previous_timepoint = 0;
+    _last_timepoint_forced = false;
+    _scan_state.assign( _nodes_count, IDLE_STATE );
+
+    // indexed again: the archive is read from the beginning
+    if( _is_archive && (!_stream || _stream->position() > 0) && !openArchive() )
+    {
+        return false;
+    }
+    return indexTransitions( progress );
+}
+
+bool ReplayLog::indexTransitions(const ProgressCallback& progress)
+{
+    const size_t PROGRESS_INTERVAL = 64*1024;
+    ReplayRecord decoded;
+
+    // the last row is always a timepoint. Remove it, if more rows follow
+    if( _last_timepoint_forced )
+    {
+        _timepoints.pop_back();
+        _last_timepoint_forced = false;
+    }
+
+    for (size_t row = _indexed_count; row < _records_count; row++)
+    {
+        if( progress && row % PROGRESS_INTERVAL == 0 &&
+            !progress( row, _records_count ) )
+        {
+            _error = Error::CANCELED;
+            return false;
+        }
+
+        const char* data = record(row);
+        if( !data || !DecodeReplayRecord( data, _uid_to_index, decoded ) )
+        {
+            _error = Error::CORRUPTED;
+            return false;
+        }
+        const int16_t index = decoded.index;
+
+        appendTimestamp( decoded.timestampUsec() );
+        _node_indices.push_back( index );
+        _statuses.push_back( PackReplayNodeState( {decoded.status, decoded.prev_status} ) );
+
+        if( row % _checkpoint_interval == 0 )
+        {
+            for (const auto& node_state: _scan_state)
+            {
+                _checkpoints.push_back( PackReplayNodeState(node_state) );
+            }
+        }
+
+        if( _restart_detector.update( decoded ) )
+        {
+            _restarts.push_back( static_cast<uint32_t>(row) );
+            std::fill( _scan_state.begin(), _scan_state.end(), IDLE_STATE );
+        }
+        applyTransition(row, _scan_state);
+        _node_rows[index].push_back( static_cast<uint32_t>(row) );
+
+        const double t = timestamp(row);
+        if( (t - _previous_timepoint) >= 0.001 )
+        {
+            _timepoints.push_back( {t, static_cast<int>(row)} );
+            _previous_timepoint = t;
+        }
+        _indexed_count = row + 1;
+    }
+    // all the records of the archive are in memory
+    _stream.reset();
+
+    const size_t last_row = _indexed_count - 1;
+    if( _indexed_count > 0 &&
+        (_timepoints.empty() || static_cast<size_t>(_timepoints.back().second) != last_row) )
+    {
+        _timepoints.push_back( {timestamp(last_row), static_cast<int>(last_row)} );
+        _last_timepoint_forced = true;
+    }
+    return true;
+}
+
+const char *ReplayLog::record(size_t row)
+{
+    if( !_is_archive )
+    {
+        return _data + _transitions_offset + row * TRANSITION_SIZE;
+    }
+    ReplayRecord decoded;
+    bool restart = false;
+    if( !_stream || _stream->position() != row || !_stream->next( decoded, restart ) )
+    {
+        return nullptr;
+    }
+    return _stream->lastRecord();
+}
+
+size_t ReplayLog::update()
+{
+    if( !_file.isOpen() || _error != Error::NONE )
+    {
+        return 0;
+    }
+
+    const qint64 new_size = _file.size();
+    if( new_size <= static_cast<qint64>(_size) )
+    {
+        return 0;
+    }
+
+    // a record that is only partially written will be read by the next update
+    const size_t new_count = (static_cast<size_t>(new_size) - _transitions_offset) / TRANSITION_SIZE;
+    if( new_count == _records_count )
+    {
+        return 0;
+    }
+
+    const uchar* mapped = _file.map( 0, new_size );
+    if( !mapped )
+    {
+        return 0;
+    }
+    _file.unmap( const_cast<uchar*>( reinterpret_cast<const uchar*>(_data) ) );
+    _data = reinterpret_cast<const char*>(mapped);
+    _size = static_cast<size_t>(new_size);
+
+    const size_t prev_count = _indexed_count;
+    _records_count = new_count;
+
+    // if this fails, the rows decoded so far are still valid.
+    // _error tells that the log can't be followed anymore
+    indexTransitions( ProgressCallback() );
+
+    return _indexed_count - prev_count;
+}
+
+void ReplayLog::appendTimestamp(uint64_t usec)
+{
+    const size_t row = _time_offsets.size();
+    if( row % TIME_BLOCK_SIZE == 0 )
+    {
+        _time_blocks.push_back( usec );
+    }
+    const uint64_t block_start = _time_blocks.back();
+
+    // the clock went backward or the block spans more than an hour: rare
+    if( usec < block_start || usec - block_start >= TIME_OVERFLOW )
+    {
+        _time_offsets.push_back( TIME_OVERFLOW );
+        _time_overflows.push_back( { static_cast<uint32_t>(row), usec } );
+    }
+    else{
+        _time_offsets.push_back( static_cast<uint32_t>(usec - block_start) );
+    }
+}
+
+uint64_t ReplayLog::timestampUsec(size_t row) const
+{
+    const uint32_t offset = _time_offsets[row];
+    if( offset != TIME_OVERFLOW )
+    {
+        return _time_blocks[ row / TIME_BLOCK_SIZE ] + offset;
+    }
+    auto it = std::lower_bound( _time_overflows.begin(), _time_overflows.end(), row,
+                                []( const std::pair<uint32_t, uint64_t>& a, size_t val ) -> bool
+    {
+        return a.first < val;
+    } );
+    return it->second;
+}
+
+double ReplayLog::timestamp(size_t row) const
+{
+    return ReplayTimestamp( timestampUsec(row) );
+}
+
+NodeStatus ReplayLog::prevStatus(size_t row) const
+{
+    return UnpackReplayNodeState( _statuses[row] ).prev_status;
+}
+
+NodeStatus ReplayLog::status(size_t row) const
+{
+    return UnpackReplayNodeState( _statuses[row] ).status;
+}
+
+ReplayLog::Transition ReplayLog::transition(size_t row) const
+{
+    Transition transition;
+    transition.timestamp   = timestamp(row);
+    transition.index       = nodeIndex(row);
+    transition.prev_status = prevStatus(row);
+    transition.status      = status(row);
+    return transition;
+}
+
+size_t ReplayLog::nearestRestart(size_t row) const
+{
+    auto it = std::upper_bound( _restarts.begin(), _restarts.end(), row );
+    if( it == _restarts.begin() )
+    {
+        return 0;
+    }
+    return *(it - 1);
+}
+
+size_t ReplayLog::ticksCount() const
+{
+    return _restarts.size() + (hasLeadingTick() ? 1 : 0);
+}
+
+size_t ReplayLog::tickStart(size_t tick) const
+{
+    if( hasLeadingTick() )
+    {
+        return (tick == 0) ? 0 : _restarts[tick - 1];
+    }
+    return _restarts[tick];
+}
+
+size_t ReplayLog::tickEnd(size_t tick) const
+{
+    return (tick + 1 < ticksCount()) ? tickStart(tick + 1) : _indexed_count;
+}
+
+size_t ReplayLog::tickAt(size_t row) const
+{
+    const size_t restarts_before = std::upper_bound( _restarts.begin(), _restarts.end(), row ) -
+                                   _restarts.begin();
+    if( hasLeadingTick() )
+    {
+        return restarts_before;
+    }
+    return restarts_before > 0 ? restarts_before - 1 : 0;
+}
+
+double ReplayLog::tickDuration(size_t tick) const
+{
+    return timestamp( tickEnd(tick) - 1 ) - timestamp( tickStart(tick) );
+}
+
+std::vector<size_t> ReplayLog::slowestTicks(size_t count) const
+{
+    std::vector<size_t> ticks( ticksCount() );
+    for (size_t tick = 0; tick < ticks.size(); tick++)
+    {
+        ticks[tick] = tick;
+    }
+    count = std::min( count, ticks.size() );
+
+    std::vector<double> durations( ticks.size() );
+    for (size_t tick = 0; tick < ticks.size(); tick++)
+    {
+        durations[tick] = tickDuration(tick);
+    }
+    std::partial_sort( ticks.begin(), ticks.begin() + count, ticks.end(),
+                       [&durations](size_t a, size_t b)
+    {
+        return durations[a] > durations[b];
+    });
+    ticks.resize( count );
+    return ticks;
+}
+
+bool ReplayLog::isTimepoint(size_t row) const
+{
+    auto it = std::lower_bound( _timepoints.begin(), _timepoints.end(), row,
+                                []( const std::pair<double,int>& a, size_t val ) -> bool
+    {
+        return static_cast<size_t>(a.second) < val;
+    } );
+    return it != _timepoints.end() && static_cast<size_t>(it->second) == row;
+}
+
+void ReplayLog::applyTransition(size_t row, std::vector<NodeState> &state) const
+{
+    auto& node_state = state[ nodeIndex(row) ];
+    node_state.prev_status = node_state.status;
+    node_state.status = status(row);
+}
+
+std::vector<ReplayLog::NodeState> ReplayLog::stateAt(size_t row) const
+{
+    std::vector<NodeState> state( _nodes_count, IDLE_STATE );
+
+    const size_t restart = nearestRestart(row);
+    const size_t checkpoint = row / _checkpoint_interval;
+    size_t first_row = restart;
+
+    // there is no restart between the checkpoint and the row
+    if( checkpoint * _checkpoint_interval > restart &&
+        (checkpoint + 1) * _nodes_count <= _checkpoints.size() )
+    {
+        const uint8_t* packed = &_checkpoints[ checkpoint * _nodes_count ];
+        for (size_t index = 0; index < _nodes_count; index++)
+        {
+            state[index] = UnpackReplayNodeState( packed[index] );
+        }
+        first_row = checkpoint * _checkpoint_interval;
+    }
+
+    for (size_t t = first_row; t <= row; t++)
+    {
+        applyTransition(t, state);
+    }
+    return state;
+}
+
+void ReplayLog::updateState(size_t from_row, size_t to_row, std::vector<NodeState> &state) const
+{
+    if( to_row <= from_row || to_row - from_row > _checkpoint_interval ||
+        nearestRestart(to_row) > from_row || state.size() != _nodes_count )
+    {
+        state = stateAt(to_row);
+        return;
+    }
+    for (size_t t = from_row + 1; t <= to_row; t++)
+    {
+        applyTransition(t, state);
+    }
+}
+
+size_t ReplayLog::lowerBoundRow(double time) const
+{
+    size_t first = 0;
+    size_t count = _indexed_count;
+    while( count > 0 )
+    {
+        const size_t step = count / 2;
+        if( timestamp(first + step) < time )
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else{
+            count = step;
+        }
+    }
+    return first;
+}
@@ -0,0 +1,206 @@
+#ifndef REPLAY_LOG_H
+#define REPLAY_LOG_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "replay_format.h"
+#include "replay_stream.h"
+
+using BT::NodeStatus;
+
+/**
+ * Read-only access to a .fbl log, i.e. a flatbuffer header describing the
+ * tree followed by a stream of 12 bytes long transitions.
+ *
+ * Files are memory-mapped and decoded once by buildIndex() into a columnar
+ * store: timestamps as offsets from the first timestamp of their block,
+ * 16 bits node indices and both statuses packed in one byte (7 bytes).
+ * The posting list of each node adds 4 bytes, so a transition takes about
+ * 11 bytes. On top of that there are 16 bytes per timepoint and a checkpoint
+ * of nodesCount() bytes every checkpoint_interval transitions.
+ *
+ * Archives (see ReplayArchive) are streamed by buildIndex() into the same
+ * store, one chunk at a time: once open, they take the memory of a plain log.
+ */
+class ReplayLog
+{
+public:
+
+    enum class Error{ NONE, CANT_OPEN, EMPTY, CORRUPTED, INVALID_FORMAT, CANCELED };
+
+    // Called periodically with the number of rows processed so far.
+    // Return false to cancel the operation.
+    typedef std::function<bool(size_t done, size_t total)> ProgressCallback;
+
+    struct Transition{
+        double timestamp;
+        int16_t index;
+        NodeStatus prev_status;
+        NodeStatus status;
+    };
+
+    typedef ReplayNodeState NodeState;
+
+    static const size_t TRANSITION_SIZE = REPLAY_RECORD_SIZE;
+
+    static const size_t DEFAULT_CHECKPOINT_INTERVAL = 1024;
+
+    ReplayLog();
+
+    bool openFile(const QString& file_name);
+
+    bool openBuffer(const QByteArray& content);
+
+    Error error() const { return _error; }
+
+    const Serialization::BehaviorTree* behaviorTree() const;
+
+    // Decode the transitions sequentially into the columnar store and find
+    // where the tree was restarted and where time moved forward (timepoints).
+    // A snapshot of the state of all the nodes is stored every
+    // checkpoint_interval transitions.
+    // It is safe to call this from a worker thread.
+    bool buildIndex(const ProgressCallback& progress = ProgressCallback(),
+                    size_t checkpoint_interval = DEFAULT_CHECKPOINT_INTERVAL);
+
+    // True if the log was opened with openFile() and it is not an archive.
+    bool isMappedFile() const { return _file.isOpen(); }
+
+    // The file might be still written by the logger. Map the new content, if any,
+    // and index the new transitions. Returns the number of new transitions.
+    size_t update();
+
+    // Number of nodes, including the "Root" added by BuildTreeFromFlatbuffers.
+    size_t nodesCount() const { return _nodes_count; }
+
+    // Number of decoded transitions. Zero until buildIndex() is called.
+    size_t transitionsCount() const { return _indexed_count; }
+
+    double timestamp(size_t row) const;
+
+    int16_t nodeIndex(size_t row) const { return _node_indices[row]; }
+
+    NodeStatus prevStatus(size_t row) const;
+
+    NodeStatus status(size_t row) const;
+
+    Transition transition(size_t row) const;
+
+    // First transition of the tick that contains the given row.
+    size_t nearestRestart(size_t row) const;
+
+    const std::vector<uint32_t>& restarts() const { return _restarts; }
+
+    // A tick starts at every restart. The rows before the first restart,
+    // if any, are a tick too.
+    size_t ticksCount() const;
+
+    size_t tickStart(size_t tick) const;
+
+    // one past the last row of the tick
+    size_t tickEnd(size_t tick) const;
+
+    // tick that contains the row, with a binary search
+    size_t tickAt(size_t row) const;
+
+    // seconds from the first to the last transition of the tick
+    double tickDuration(size_t tick) const;
+
+    // up to "count" ticks, sorted by decreasing duration
+    std::vector<size_t> slowestTicks(size_t count) const;
+
+    // State of all the nodes after the transition at the given row.
+    // The state is reset to IDLE every time the tree is restarted.
+    // Starts from the closest checkpoint, i.e. it applies at most
+    // checkpoint_interval transitions.
+    std::vector<NodeState> stateAt(size_t row) const;
+
+    // Move a state computed with stateAt(from_row) to to_row. Short steps forward
+    // inside the same tick apply only the transitions in between.
+    void updateState(size_t from_row, size_t to_row, std::vector<NodeState>& state) const;
+
+    // Sorted rows of the transitions of a node (posting list).
+    const std::vector<uint32_t>& nodeRows(size_t index) const { return _node_rows[index]; }
+
+    // First row with timestamp >= time. Timestamps are assumed to be monotonic.
+    size_t lowerBoundRow(double time) const;
+
+    // Pairs {timestamp, row} of the rows where time advanced by at least 1 ms.
+    const std::vector< std::pair<double,int> >& timepoints() const { return _timepoints; }
+
+    bool isTimepoint(size_t row) const;
+
+private:
+
+    bool parseHeader();
+
+    // start reading the archive from its first record
+    bool openArchive();
+
+    // continue the scan started by buildIndex() up to the last complete record
+    bool indexTransitions(const ProgressCallback& progress);
+
+    void applyTransition(size_t row, std::vector<NodeState>& state) const;
+
+    bool hasLeadingTick() const
+    {
+        return _indexed_count > 0 && (_restarts.empty() || _restarts.front() != 0);
+    }
+
+    uint64_t timestampUsec(size_t row) const;
+
+    void appendTimestamp(uint64_t usec);
+
+    // Records of an archive are read in order, once.
+    // nullptr if the record can't be read
+    const char* record(size_t row);
+
+    QFile _file;
+    QByteArray _buffer;
+    // if true, _buffer contains only the header and the records are read by
+    // _stream, until all of them are indexed
+    bool _is_archive;
+    std::unique_ptr<ReplayStream> _stream;
+    const char* _data;
+    size_t _size;
+
+    Error _error;
+    size_t _transitions_offset;
+    // complete records in the mapped region
+    size_t _records_count;
+    size_t _nodes_count;
+
+    // columns of the decoded transitions.
+    // Microseconds from the first timestamp of the block (TIME_BLOCK_SIZE rows)
+    // or TIME_OVERFLOW, if the offset doesn't fit into 32 bits.
+    std::vector<uint32_t> _time_offsets;
+    std::vector<uint64_t> _time_blocks;
+    std::vector< std::pair<uint32_t, uint64_t> > _time_overflows;
+    std::vector<int16_t> _node_indices;
+    // status and prev_status, see PackReplayNodeState()
+    std::vector<uint8_t> _statuses;
+
+    // dense, indexed by uid. -1 if the uid is not part of the tree
+    std::vector<int16_t> _uid_to_index;
+    std::vector<uint32_t> _restarts;
+    std::vector< std::pair<double,int> > _timepoints;
+    std::vector< std::vector<uint32_t> > _node_rows;
+
+    // nodesCount() bytes per checkpoint, see PackReplayNodeState()
+    size_t _checkpoint_interval;
+    std::vector<uint8_t> _checkpoints;
+
+    // status of the scan, needed to index the transitions appended later
+    size_t _indexed_count;
+    ReplayRestartDetector _restart_detector;
+    double _previous_timepoint;
+    bool _last_timepoint_forced;
+    std::vector<NodeState> _scan_state;
+};
+
+#endif // REPLAY_LOG_H
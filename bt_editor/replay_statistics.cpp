@@ -0,0 +1,184 @@
+#include "replay_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double BUCKET_RATIO = 1.05;
+
+const size_t BUCKETS_COUNT =
+        2 + static_cast<size_t>( std::log( DurationHistogram::MAX_DURATION /
+                                           DurationHistogram::MIN_DURATION ) /
+                                 std::log( BUCKET_RATIO ) );
+
+}
+
+constexpr double DurationHistogram::MIN_DURATION;
+constexpr double DurationHistogram::MAX_DURATION;
+
+DurationHistogram::DurationHistogram():
+    _count(0),
+    _sum(0),
+    _max(0)
+{
+}
+
+void DurationHistogram::add(double seconds)
+{
+    // bucket 0 contains everything below MIN_DURATION
+    size_t bucket = 0;
+    if( seconds >= MIN_DURATION )
+    {
+        bucket = 1 + static_cast<size_t>( std::log( seconds / MIN_DURATION ) /
+                                          std::log( BUCKET_RATIO ) );
+        bucket = std::min( bucket, BUCKETS_COUNT - 1 );
+    }
+    if( bucket >= _buckets.size() )
+    {
+        _buckets.resize( bucket + 1, 0 );
+    }
+    _buckets[bucket]++;
+    _count++;
+    _sum += seconds;
+    _max = std::max( _max, seconds );
+}
+
+double DurationHistogram::percentile(double ratio) const
+{
+    if( _count == 0 )
+    {
+        return 0;
+    }
+    const size_t rank = std::min( _count - 1, static_cast<size_t>( ratio * _count ) );
+    size_t seen = 0;
+    for (size_t bucket = 0; bucket < _buckets.size(); bucket++)
+    {
+        seen += _buckets[bucket];
+        if( seen > rank )
+        {
+            if( bucket == 0 )
+            {
+                return 0;
+            }
+            // geometric center of the bucket
+            const double value = MIN_DURATION * std::pow( BUCKET_RATIO, bucket - 0.5 );
+            return std::min( value, _max );
+        }
+    }
+    return _max;
+}
+
+ReplayStatistics::NodeAccumulator::NodeAccumulator():
+    ticks(0),
+    successes(0),
+    failures(0),
+    running_time(0),
+    start_time(-1),
+    running_since(-1),
+    first_failure(-1)
+{
+}
+
+ReplayStatistics::ReplayStatistics(size_t nodes_count):
+    _nodes(nodes_count),
+    _processed_count(0)
+{
+}
+
+bool ReplayStatistics::process(const ReplayLog &log, const ReplayLog::ProgressCallback &progress)
+{
+    const size_t PROGRESS_INTERVAL = 64*1024;
+    const size_t count = log.transitionsCount();
+
+    if( _nodes.size() < log.nodesCount() )
+    {
+        _nodes.resize( log.nodesCount() );
+    }
+
+    for (size_t row = _processed_count; row < count; row++)
+    {
+        if( progress && row % PROGRESS_INTERVAL == 0 && !progress( row, count ) )
+        {
+            return false;
+        }
+        add( log.nodeIndex(row), log.prevStatus(row), log.status(row), log.timestamp(row) );
+    }
+    return true;
+}
+
+void ReplayStatistics::add(int16_t index, NodeStatus prev_status, NodeStatus status, double t)
+{
+    if( static_cast<size_t>(index) >= _nodes.size() )
+    {
+        _nodes.resize( index + 1 );
+    }
+    NodeAccumulator& node = _nodes[index];
+
+    if( prev_status == NodeStatus::RUNNING && node.running_since >= 0 )
+    {
+        node.running_time += t - node.running_since;
+        node.running_since = -1;
+    }
+
+    if( prev_status == NodeStatus::IDLE && status != NodeStatus::IDLE )
+    {
+        node.ticks++;
+        node.start_time = t;
+    }
+
+    switch( status )
+    {
+    case NodeStatus::RUNNING:
+        node.running_since = t;
+        break;
+
+    case NodeStatus::SUCCESS:
+    case NodeStatus::FAILURE:
+        if( status == NodeStatus::SUCCESS ){
+            node.successes++;
+        }
+        else{
+            node.failures++;
+            if( node.first_failure < 0 )
+            {
+                node.first_failure = t;
+            }
+        }
+        if( node.start_time >= 0 )
+        {
+            node.latencies.add( t - node.start_time );
+            node.start_time = -1;
+        }
+        break;
+
+    case NodeStatus::IDLE:
+        // halted
+        node.start_time = -1;
+        break;
+    }
+    _processed_count++;
+}
+
+std::vector<ReplayStatistics::NodeSummary> ReplayStatistics::summary() const
+{
+    std::vector<NodeSummary> summary;
+    summary.reserve( _nodes.size() );
+
+    for (const auto& node: _nodes)
+    {
+        NodeSummary node_summary;
+        node_summary.ticks         = node.ticks;
+        node_summary.successes     = node.successes;
+        node_summary.failures      = node.failures;
+        node_summary.running_time  = node.running_time;
+        node_summary.latency_mean  = node.latencies.mean();
+        node_summary.latency_p50   = node.latencies.percentile( 0.50 );
+        node_summary.latency_p90   = node.latencies.percentile( 0.90 );
+        node_summary.latency_p99   = node.latencies.percentile( 0.99 );
+        node_summary.latency_max   = node.latencies.max();
+        node_summary.first_failure = node.first_failure;
+        summary.push_back( node_summary );
+    }
+    return summary;
+}
@@ -0,0 +1,107 @@
+#ifndef REPLAY_STATISTICS_H
+#define REPLAY_STATISTICS_H
+
+#include <vector>
+
+#include "replay_log.h"
+
+/**
+ * Histogram of durations with buckets growing exponentially (5% each), from
+ * MIN_DURATION to MAX_DURATION seconds. The memory used doesn't depend on
+ * the number of samples; percentiles have a relative error below 2.5%,
+ * while count, mean and max are exact.
+ */
+class DurationHistogram
+{
+public:
+
+    static constexpr double MIN_DURATION = 1e-6;
+    static constexpr double MAX_DURATION = 1e4;
+
+    DurationHistogram();
+
+    void add(double seconds);
+
+    size_t count() const { return _count; }
+
+    double mean() const { return _count == 0 ? 0 : _sum / _count; }
+
+    double max() const { return _max; }
+
+    // nearest-rank percentile, 0 if there are no samples
+    double percentile(double ratio) const;
+
+private:
+
+    // grows up to the highest bucket used
+    std::vector<uint32_t> _buckets;
+    size_t _count;
+    double _sum;
+    double _max;
+};
+
+/**
+ * Per-node timing and status statistics of a ReplayLog.
+ *
+ * The transitions are processed once, in order. New transitions appended to
+ * the log (follow mode) can be processed later without starting again.
+ * Memory is proportional to the number of nodes, not of transitions, so that
+ * it can be used while streaming a log (see ReplayStream).
+ */
+class ReplayStatistics
+{
+public:
+
+    struct NodeSummary{
+        // times the node left IDLE
+        size_t ticks;
+        size_t successes;
+        size_t failures;
+        // seconds spent in RUNNING
+        double running_time;
+        // seconds from leaving IDLE to SUCCESS or FAILURE
+        double latency_mean;
+        double latency_p50;
+        double latency_p90;
+        double latency_p99;
+        double latency_max;
+        // timestamp of the first FAILURE, negative if it never failed
+        double first_failure;
+    };
+
+    explicit ReplayStatistics(size_t nodes_count = 0);
+
+    // Process the transitions not processed yet.
+    // It is safe to call this from a worker thread, as long as the log is not
+    // modified at the same time.
+    bool process(const ReplayLog& log,
+                 const ReplayLog::ProgressCallback& progress = ReplayLog::ProgressCallback());
+
+    // Add a single transition. Transitions must be added in order.
+    void add(int16_t index, NodeStatus prev_status, NodeStatus status, double timestamp);
+
+    size_t processedCount() const { return _processed_count; }
+
+    // Indexed by node index.
+    std::vector<NodeSummary> summary() const;
+
+private:
+
+    struct NodeAccumulator{
+        NodeAccumulator();
+        size_t ticks;
+        size_t successes;
+        size_t failures;
+        double running_time;
+        // negative if not started / not RUNNING
+        double start_time;
+        double running_since;
+        double first_failure;
+        DurationHistogram latencies;
+    };
+
+    std::vector<NodeAccumulator> _nodes;
+    size_t _processed_count;
+};
+
+#endif // REPLAY_STATISTICS_H
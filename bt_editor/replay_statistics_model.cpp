@@ -0,0 +1,144 @@
+#include "replay_statistics_model.h"
+
+ReplayStatisticsModel::ReplayStatisticsModel(QObject *parent) :
+    QAbstractTableModel(parent)
+{
+}
+
+void ReplayStatisticsModel::setStatistics(const ReplayStatistics &statistics,
+                                          const AbsBehaviorTree &tree)
+{
+    beginResetModel();
+    _node_names.clear();
+    _summary.clear();
+
+    const auto summary = statistics.summary();
+    for (size_t index = 1; index < tree.nodesCount() && index < summary.size(); index++)
+    {
+        _node_names.push_back( tree.nodes()[index].instance_name );
+        _summary.push_back( summary[index] );
+    }
+    endResetModel();
+}
+
+void ReplayStatisticsModel::clear()
+{
+    beginResetModel();
+    _node_names.clear();
+    _summary.clear();
+    endResetModel();
+}
+
+int ReplayStatisticsModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>( _summary.size() );
+}
+
+int ReplayStatisticsModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : COLUMNS_COUNT;
+}
+
+QVariant ReplayStatisticsModel::value(int row, int column) const
+{
+    const auto& node = _summary[row];
+    const size_t completed = node.successes + node.failures;
+
+    switch( column )
+    {
+    case NODE_NAME:    return _node_names[row];
+    case TICKS:        return static_cast<qulonglong>( node.ticks );
+    case SUCCESS_RATE: return completed == 0 ? QVariant() : double(node.successes) / completed;
+    case FAILURE_RATE: return completed == 0 ? QVariant() : double(node.failures) / completed;
+    case RUNNING_TIME: return node.running_time;
+    case LATENCY_MEAN: return node.latency_mean;
+    case LATENCY_P50:  return node.latency_p50;
+    case LATENCY_P90:  return node.latency_p90;
+    case LATENCY_P99:  return node.latency_p99;
+    case LATENCY_MAX:  return node.latency_max;
+    }
+    return QVariant();
+}
+
+QVariant ReplayStatisticsModel::data(const QModelIndex &index, int role) const
+{
+    if( !index.isValid() )
+    {
+        return QVariant();
+    }
+    const QVariant cell = value( index.row(), index.column() );
+
+    switch( role )
+    {
+    case Qt::UserRole: return cell;
+
+    case Qt::DisplayRole:
+    {
+        if( !cell.isValid() )
+        {
+            return QString("-");
+        }
+        switch( index.column() )
+        {
+        case NODE_NAME:
+        case TICKS:
+            return cell;
+        case SUCCESS_RATE:
+        case FAILURE_RATE:
+            return QString("%1 %").arg( cell.toDouble() * 100.0, 0, 'f', 1 );
+        default:
+            return QString::number( cell.toDouble(), 'f', 3 );
+        }
+    }
+
+    case Qt::TextAlignmentRole:
+    {
+        if( index.column() != NODE_NAME )
+        {
+            return QVariant( Qt::AlignRight | Qt::AlignVCenter );
+        }
+    } break;
+    }
+
+    return QVariant();
+}
+
+QVariant ReplayStatisticsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if( orientation != Qt::Horizontal )
+    {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    if( role == Qt::ToolTipRole )
+    {
+        switch( section )
+        {
+        case TICKS:        return QString("Number of times the node left IDLE");
+        case RUNNING_TIME: return QString("Total seconds spent in RUNNING");
+        case LATENCY_MEAN:
+        case LATENCY_P50:
+        case LATENCY_P90:
+        case LATENCY_P99:
+        case LATENCY_MAX:  return QString("Seconds from leaving IDLE to SUCCESS or FAILURE");
+        }
+        return QVariant();
+    }
+    if( role != Qt::DisplayRole )
+    {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    switch( section )
+    {
+    case NODE_NAME:    return QString("Node Name");
+    case TICKS:        return QString("Ticks");
+    case SUCCESS_RATE: return QString("Success");
+    case FAILURE_RATE: return QString("Failure");
+    case RUNNING_TIME: return QString("Running");
+    case LATENCY_MEAN: return QString("Mean");
+    case LATENCY_P50:  return QString("P50");
+    case LATENCY_P90:  return QString("P90");
+    case LATENCY_P99:  return QString("P99");
+    case LATENCY_MAX:  return QString("Max");
+    }
+    return QVariant();
+}
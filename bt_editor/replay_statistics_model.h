@@ -0,0 +1,45 @@
+#ifndef REPLAY_STATISTICS_MODEL_H
+#define REPLAY_STATISTICS_MODEL_H
+
+#include <QAbstractTableModel>
+
+#include "bt_editor_base.h"
+#include "replay_statistics.h"
+
+/**
+ * One row per node of the tree, with its ReplayStatistics::NodeSummary.
+ * Qt::UserRole returns the numeric value of the cell, to be used as sort role.
+ */
+class ReplayStatisticsModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column{ NODE_NAME = 0, TICKS, SUCCESS_RATE, FAILURE_RATE, RUNNING_TIME,
+                 LATENCY_MEAN, LATENCY_P50, LATENCY_P90, LATENCY_P99, LATENCY_MAX,
+                 COLUMNS_COUNT };
+
+    explicit ReplayStatisticsModel(QObject *parent = nullptr);
+
+    void setStatistics(const ReplayStatistics& statistics, const AbsBehaviorTree& tree);
+
+    void clear();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+private:
+    QVariant value(int row, int column) const;
+
+    // the artificial Root (index 0) is skipped
+    std::vector<QString> _node_names;
+    std::vector<ReplayStatistics::NodeSummary> _summary;
+};
+
+#endif // REPLAY_STATISTICS_MODEL_H
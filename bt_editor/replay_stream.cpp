@@ -0,0 +1,145 @@
+#include "replay_stream.h"
+
+#include <algorithm>
+
+ReplayStream::ReplayStream():
+    _is_archive(false),
+    _archive_chunk(0),
+    _nodes_count(0),
+    _records_count(0),
+    _chunk_records(0),
+    _chunk_position(0),
+    _position(0),
+    _last_record(nullptr)
+{
+}
+
+bool ReplayStream::open(const QString &file_name)
+{
+    _file.setFileName(file_name);
+
+    if (!_file.open(QIODevice::ReadOnly)){
+        _error_string = _file.errorString();
+        return false;
+    }
+
+    const QByteArray size_bytes = _file.read(4);
+    if( size_bytes.size() < 4 ) {
+        _error_string = "The file is empty";
+        return false;
+    }
+
+    if( IsReplayArchive( size_bytes.constData(), 4 ) )
+    {
+        _file.close();
+        return openArchive( file_name );
+    }
+
+    const size_t bt_header_size = flatbuffers::ReadScalar<uint32_t>( size_bytes.constData() );
+    const size_t file_size = static_cast<size_t>( _file.size() );
+    if( bt_header_size == 0 || bt_header_size > file_size - 4 ) {
+        _error_string = "The header is corrupted";
+        return false;
+    }
+
+    // ParseReplayHeader verifies the size prefix too
+    _header = size_bytes + _file.read( static_cast<qint64>(bt_header_size) );
+
+    size_t transitions_offset = 0;
+    if( ParseReplayHeader( _header.constData(), static_cast<size_t>( _header.size() ),
+                           transitions_offset, _uid_to_index ) != ReplayFormatError::NONE )
+    {
+        _error_string = "The header is not a valid BehaviorTree";
+        return false;
+    }
+
+    _nodes_count = behaviorTree()->nodes()->size() + 1;
+    // transitions_offset is relative to the header copy, same as in the file
+    _records_count = (file_size - transitions_offset) / REPLAY_RECORD_SIZE;
+    _restart_detector = ReplayRestartDetector( _nodes_count );
+    _position = 0;
+    return true;
+}
+
+bool ReplayStream::openArchive(const QString &file_name)
+{
+    if( !_archive.open( file_name ) )
+    {
+        _error_string = _archive.errorString();
+        return false;
+    }
+    _is_archive = true;
+    _archive_chunk = 0;
+    _header = _archive.header();
+    _uid_to_index = _archive.uidToIndex();
+    _nodes_count = _archive.nodesCount();
+    _records_count = _archive.recordsCount();
+    _restart_detector = ReplayRestartDetector( _nodes_count );
+    _position = 0;
+    return true;
+}
+
+const Serialization::BehaviorTree *ReplayStream::behaviorTree() const
+{
+    return Serialization::GetBehaviorTree( &_header.constData()[4] );
+}
+
+bool ReplayStream::readChunk()
+{
+    if( _is_archive )
+    {
+        if( _archive_chunk >= _archive.chunks().size() )
+        {
+            return false;
+        }
+        if( !_archive.readChunk( _archive_chunk++, _chunk ) )
+        {
+            _error_string = _archive.errorString();
+            return false;
+        }
+        _chunk_records = static_cast<size_t>( _chunk.size() ) / REPLAY_RECORD_SIZE;
+        _chunk_position = 0;
+        return _chunk_records > 0;
+    }
+
+    const size_t count = std::min( CHUNK_RECORDS, _records_count - _position );
+    if( count == 0 )
+    {
+        return false;
+    }
+    // QByteArray keeps its capacity: this allocates only once
+    _chunk.resize( static_cast<int>(count * REPLAY_RECORD_SIZE) );
+    const qint64 read = _file.read( _chunk.data(), _chunk.size() );
+    if( read < 0 )
+    {
+        _error_string = _file.errorString();
+        return false;
+    }
+    _chunk_records = static_cast<size_t>(read) / REPLAY_RECORD_SIZE;
+    _chunk_position = 0;
+    return _chunk_records > 0;
+}
+
+bool ReplayStream::next(ReplayRecord &record, bool &restart)
+{
+    if( hasError() || _position >= _records_count )
+    {
+        return false;
+    }
+    if( _chunk_position >= _chunk_records && !readChunk() )
+    {
+        return false;
+    }
+
+    const char* data = _chunk.constData() + _chunk_position * REPLAY_RECORD_SIZE;
+    if( !DecodeReplayRecord( data, _uid_to_index, record ) )
+    {
+        _error_string = QString("Unknown node uid in transition %1").arg(_position);
+        return false;
+    }
+    restart = _restart_detector.update( record );
+    _last_record = data;
+    _chunk_position++;
+    _position++;
+    return true;
+}
@@ -0,0 +1,84 @@
+#ifndef REPLAY_STREAM_H
+#define REPLAY_STREAM_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <vector>
+
+#include "replay_format.h"
+#include "replay_archive.h"
+
+/**
+ * Sequential reader of a .fbl log, for tools that need to visit all the
+ * transitions once. Unlike ReplayLog nothing is kept in memory but the header
+ * and a chunk of records, so the size of the file doesn't matter.
+ * Both plain logs and archives (see ReplayArchive) can be read.
+ */
+class ReplayStream
+{
+public:
+
+    static const size_t CHUNK_RECORDS = 64*1024;
+
+    ReplayStream();
+
+    bool open(const QString& file_name);
+
+    // True if the file can't be read or a record is corrupted.
+    // next() returns false in both cases.
+    bool hasError() const { return !_error_string.isEmpty(); }
+
+    QString errorString() const { return _error_string; }
+
+    // as in a .fbl file: 4 bytes with the size of the flatbuffer, then the flatbuffer
+    const QByteArray& header() const { return _header; }
+
+    const Serialization::BehaviorTree* behaviorTree() const;
+
+    // Number of nodes, including the "Root" added by BuildTreeFromFlatbuffers.
+    size_t nodesCount() const { return _nodes_count; }
+
+    // Read the next transition. "restart" is true if the tree was restarted
+    // by it (see ReplayRestartDetector).
+    // Returns false at the end of the file or if a record is corrupted.
+    bool next(ReplayRecord& record, bool& restart);
+
+    // the 12 bytes of the last record returned by next(), as in a .fbl file
+    const char* lastRecord() const { return _last_record; }
+
+    // records read so far
+    size_t position() const { return _position; }
+
+    // total number of complete records in the file
+    size_t recordsCount() const { return _records_count; }
+
+private:
+
+    bool openArchive(const QString& file_name);
+
+    bool readChunk();
+
+    QFile _file;
+    // used instead of _file, if the file is an archive
+    ReplayArchive _archive;
+    bool _is_archive;
+    size_t _archive_chunk;
+
+    QByteArray _header;
+    std::vector<int16_t> _uid_to_index;
+    size_t _nodes_count;
+    size_t _records_count;
+
+    QString _error_string;
+
+    QByteArray _chunk;
+    size_t _chunk_records;
+    size_t _chunk_position;
+    size_t _position;
+    const char* _last_record;
+
+    ReplayRestartDetector _restart_detector;
+};
+
+#endif // REPLAY_STREAM_H
@@ -0,0 +1,220 @@
+#include "replay_table_model.h"
+
+#include <algorithm>
+#include <QColor>
+#include <QFont>
+
+namespace {
+
+const char* statusName(NodeStatus status)
+{
+    switch (status)
+    {
+    case NodeStatus::SUCCESS: return "SUCCESS";
+    case NodeStatus::FAILURE: return "FAILURE";
+    case NodeStatus::RUNNING: return "RUNNING";
+    case NodeStatus::IDLE:    return "IDLE";
+    }
+    return "";
+}
+
+QColor statusColor(NodeStatus status)
+{
+    switch (status)
+    {
+    case NodeStatus::SUCCESS: return QColor::fromRgb(22, 255, 22);
+    case NodeStatus::FAILURE: return QColor::fromRgb(255, 22, 22);
+    case NodeStatus::RUNNING: return QColor::fromRgb(250, 160, 20);
+    case NodeStatus::IDLE:    return QColor::fromRgb(222, 222, 222);
+    }
+    return QColor();
+}
+
+}
+
+ReplayTableModel::ReplayTableModel(QObject *parent) :
+    QAbstractTableModel(parent),
+    _first_timestamp(0),
+    _rows_count(0),
+    _current_row(-1),
+    _marked_row(-1)
+{
+}
+
+void ReplayTableModel::setLog(std::shared_ptr<const ReplayLog> log,
+                              const AbsBehaviorTree &tree)
+{
+    beginResetModel();
+    _log = log;
+    _node_names.clear();
+    _node_names.reserve( tree.nodesCount() );
+    for (const auto& node: tree.nodes())
+    {
+        _node_names.push_back( node.instance_name );
+    }
+    _first_timestamp = (_log && _log->transitionsCount() > 0) ? _log->timestamp(0) : 0;
+    _rows_count = _log ? static_cast<int>( _log->transitionsCount() ) : 0;
+    _current_row = -1;
+    _marked_row = -1;
+    endResetModel();
+}
+
+void ReplayTableModel::transitionsAppended()
+{
+    const int new_count = _log ? static_cast<int>( _log->transitionsCount() ) : 0;
+    if( new_count <= _rows_count )
+    {
+        return;
+    }
+    if( _rows_count == 0 )
+    {
+        _first_timestamp = _log->timestamp(0);
+    }
+    beginInsertRows( QModelIndex(), _rows_count, new_count - 1 );
+    const int prev_last_row = _rows_count - 1;
+    _rows_count = new_count;
+    endInsertRows();
+
+    // it might not be a timepoint anymore
+    if( prev_last_row >= 0 )
+    {
+        emit dataChanged( index(prev_last_row, TIME), index(prev_last_row, TIME), {Qt::FontRole} );
+    }
+}
+
+void ReplayTableModel::clear()
+{
+    setLog( nullptr, AbsBehaviorTree() );
+}
+
+void ReplayTableModel::setCurrentRow(int current_row)
+{
+    if( current_row == _current_row )
+    {
+        return;
+    }
+    const int first = std::max(0, std::min(current_row, _current_row) + 1);
+    const int last  = std::min(std::max(current_row, _current_row), rowCount() - 1);
+    _current_row = current_row;
+
+    if( first <= last )
+    {
+        emit dataChanged( index(first, TIME), index(last, NODE_NAME), {Qt::BackgroundRole} );
+    }
+}
+
+void ReplayTableModel::setMarkedRow(int marked_row)
+{
+    const int prev_marked_row = _marked_row;
+    _marked_row = marked_row;
+
+    for (int row: { prev_marked_row, marked_row })
+    {
+        if( row >= 0 && row < rowCount() )
+        {
+            emit dataChanged( index(row, TIME), index(row, NODE_NAME), {Qt::BackgroundRole} );
+        }
+    }
+}
+
+QString ReplayTableModel::nodeName(int row) const
+{
+    return _node_names[ _log->nodeIndex(row) ];
+}
+
+int ReplayTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : _rows_count;
+}
+
+int ReplayTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : COLUMNS_COUNT;
+}
+
+QVariant ReplayTableModel::data(const QModelIndex &index, int role) const
+{
+    if( !index.isValid() || !_log )
+    {
+        return QVariant();
+    }
+    const int row = index.row();
+
+    switch( role )
+    {
+    case Qt::DisplayRole:
+    {
+        switch( index.column() )
+        {
+        case TIME:        return QString::number( _log->timestamp(row) - _first_timestamp, 'f', 3 );
+        case NODE_NAME:   return nodeName(row);
+        case PREV_STATUS: return QString( statusName( _log->prevStatus(row) ) );
+        case STATUS:      return QString( statusName( _log->status(row) ) );
+        }
+    } break;
+
+    case Qt::ToolTipRole:
+    {
+        if( index.column() == TIME )
+        {
+            return QString("absolute time: %1").arg( _log->timestamp(row), 0, 'f', 3 );
+        }
+    } break;
+
+    case Qt::FontRole:
+    {
+        if( index.column() == TIME && _log->isTimepoint(row) )
+        {
+            QFont font;
+            font.setBold(true);
+            return font;
+        }
+    } break;
+
+    case Qt::BackgroundRole:
+    {
+        switch( index.column() )
+        {
+        case TIME:
+        case NODE_NAME:
+            if( row == _marked_row )
+            {
+                return QColor::fromRgb(255, 170, 170);
+            }
+            if( row <= _current_row )
+            {
+                return QColor::fromRgb(210, 210, 210);
+            }
+            break;
+        case PREV_STATUS: return statusColor( _log->prevStatus(row) );
+        case STATUS:      return statusColor( _log->status(row) );
+        }
+    } break;
+
+    case Qt::ForegroundRole:
+    {
+        if( index.column() == PREV_STATUS || index.column() == STATUS )
+        {
+            return QColor::fromRgb(0, 0, 0);
+        }
+    } break;
+    }
+
+    return QVariant();
+}
+
+QVariant ReplayTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if( orientation != Qt::Horizontal || role != Qt::DisplayRole )
+    {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    switch( section )
+    {
+    case TIME:        return QString("Time");
+    case NODE_NAME:   return QString("Node Name");
+    case PREV_STATUS: return QString("Previous");
+    case STATUS:      return QString("Status");
+    }
+    return QVariant();
+}
@@ -0,0 +1,62 @@
+#ifndef REPLAY_TABLE_MODEL_H
+#define REPLAY_TABLE_MODEL_H
+
+#include <memory>
+#include <QAbstractTableModel>
+
+#include "bt_editor_base.h"
+#include "replay_log.h"
+
+/**
+ * Table of the transitions of a ReplayLog. Cells are not stored: they are
+ * created on demand from the log when the view asks for them.
+ */
+class ReplayTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column{ TIME = 0, NODE_NAME, PREV_STATUS, STATUS, COLUMNS_COUNT };
+
+    explicit ReplayTableModel(QObject *parent = nullptr);
+
+    void setLog(std::shared_ptr<const ReplayLog> log, const AbsBehaviorTree& tree);
+
+    void clear();
+
+    // to be called when new transitions were appended to the log
+    void transitionsAppended();
+
+    // rows up to current_row (included) are highlighted
+    void setCurrentRow(int current_row);
+
+    // highlight a single row, for instance where two logs diverge
+    void setMarkedRow(int marked_row);
+
+    QString nodeName(int row) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+private:
+    std::shared_ptr<const ReplayLog> _log;
+
+    // indexed by node index
+    std::vector<QString> _node_names;
+
+    double _first_timestamp;
+
+    int _rows_count;
+
+    int _current_row;
+
+    int _marked_row;
+};
+
+#endif // REPLAY_TABLE_MODEL_H
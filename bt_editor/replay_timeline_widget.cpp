@@ -0,0 +1,443 @@
+#include "replay_timeline_widget.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QWheelEvent>
+
+namespace {
+
+const int LANE_HEIGHT = 16;
+const int AXIS_HEIGHT = 20;
+const int BAR_MARGIN  = 3;
+const int NAME_INDENT = 8;
+// minimum distance, in pixels, between two labels of the time axis
+const int LABEL_SPACING = 80;
+const size_t BLOCK_SIZE = 64;
+
+uint8_t statusBit(NodeStatus status)
+{
+    return static_cast<uint8_t>( 1 << static_cast<int>(status) );
+}
+
+NodeStatus worstStatus(uint8_t mask)
+{
+    if( mask & statusBit(NodeStatus::FAILURE) ) return NodeStatus::FAILURE;
+    if( mask & statusBit(NodeStatus::RUNNING) ) return NodeStatus::RUNNING;
+    if( mask & statusBit(NodeStatus::SUCCESS) ) return NodeStatus::SUCCESS;
+    return NodeStatus::IDLE;
+}
+
+QColor statusColor(NodeStatus status)
+{
+    switch (status)
+    {
+    case NodeStatus::SUCCESS: return QColor::fromRgb(22, 255, 22);
+    case NodeStatus::FAILURE: return QColor::fromRgb(255, 22, 22);
+    case NodeStatus::RUNNING: return QColor::fromRgb(250, 160, 20);
+    case NodeStatus::IDLE:    return QColor::fromRgb(222, 222, 222);
+    }
+    return QColor();
+}
+
+}
+
+ReplayTimelineWidget::ReplayTimelineWidget(QWidget *parent) :
+    QWidget(parent),
+    _view_start(0),
+    _view_end(1),
+    _full_view(true),
+    _cursor_time(-1),
+    _press_view_start(0),
+    _dragging(false)
+{
+    setToolTip( tr("Click: jump to the transition\n"
+                   "Drag: move\n"
+                   "Ctrl + Wheel: zoom\n"
+                   "Double click: show the entire log") );
+}
+
+void ReplayTimelineWidget::setLog(std::shared_ptr<const ReplayLog> log, const AbsBehaviorTree &tree)
+{
+    _log = log;
+    _lanes.clear();
+    _cursor_time = -1;
+
+    // same order of the tree, depth first. The Root (index 0) has no lane
+    std::function<void(int,int)> addLanes = [&](int index, int depth)
+    {
+        const auto& node = tree.nodes()[index];
+        if( index > 0 && _log && static_cast<size_t>(index) < _log->nodesCount() )
+        {
+            Lane lane;
+            lane.index = static_cast<size_t>(index);
+            lane.name  = node.instance_name;
+            lane.depth = depth - 1;
+            updateBlocks( lane );
+            _lanes.push_back( std::move(lane) );
+        }
+        for (int child: node.children_index)
+        {
+            addLanes( child, depth + 1 );
+        }
+    };
+    if( tree.nodesCount() > 0 )
+    {
+        addLanes( 0, 0 );
+    }
+
+    setMinimumHeight( AXIS_HEIGHT + static_cast<int>(_lanes.size()) * LANE_HEIGHT );
+    resetView();
+}
+
+void ReplayTimelineWidget::clear()
+{
+    setLog( nullptr, AbsBehaviorTree() );
+}
+
+void ReplayTimelineWidget::transitionsAppended()
+{
+    for (auto& lane: _lanes)
+    {
+        updateBlocks( lane );
+    }
+    if( _full_view )
+    {
+        resetView();
+    }
+    update();
+}
+
+void ReplayTimelineWidget::setCurrentRow(int row)
+{
+    if( !_log || row < 0 || static_cast<size_t>(row) >= _log->transitionsCount() )
+    {
+        return;
+    }
+    _cursor_time = _log->timestamp(row);
+    update();
+}
+
+QSize ReplayTimelineWidget::sizeHint() const
+{
+    return QSize( 400, AXIS_HEIGHT + static_cast<int>(_lanes.size()) * LANE_HEIGHT );
+}
+
+void ReplayTimelineWidget::updateBlocks(Lane &lane)
+{
+    if( !_log )
+    {
+        return;
+    }
+    const auto& rows = _log->nodeRows( lane.index );
+    const size_t complete_blocks = rows.size() / BLOCK_SIZE;
+
+    for (size_t block = lane.blocks.size(); block < complete_blocks; block++)
+    {
+        uint8_t mask = 0;
+        for (size_t i = block * BLOCK_SIZE; i < (block + 1) * BLOCK_SIZE; i++)
+        {
+            mask |= statusBit( _log->status( rows[i] ) );
+        }
+        lane.blocks.push_back( mask );
+    }
+}
+
+uint8_t ReplayTimelineWidget::statusMask(const Lane &lane, size_t first, size_t last) const
+{
+    const auto& rows = _log->nodeRows( lane.index );
+    uint8_t mask = 0;
+
+    while( first < last && first % BLOCK_SIZE != 0 )
+    {
+        mask |= statusBit( _log->status( rows[first++] ) );
+    }
+    while( first + BLOCK_SIZE <= last )
+    {
+        mask |= lane.blocks[ first / BLOCK_SIZE ];
+        first += BLOCK_SIZE;
+    }
+    while( first < last )
+    {
+        mask |= statusBit( _log->status( rows[first++] ) );
+    }
+    return mask;
+}
+
+int ReplayTimelineWidget::namesWidth() const
+{
+    return std::min( 160, width() / 3 );
+}
+
+double ReplayTimelineWidget::timeAt(double x) const
+{
+    const double names_width = namesWidth();
+    return _view_start + (x - names_width) * (_view_end - _view_start) /
+                         std::max(1.0, width() - names_width);
+}
+
+double ReplayTimelineWidget::xAt(double time) const
+{
+    const double names_width = namesWidth();
+    return names_width + (time - _view_start) * std::max(1.0, width() - names_width) /
+                         (_view_end - _view_start);
+}
+
+void ReplayTimelineWidget::resetView()
+{
+    _full_view = true;
+    if( !_log || _log->transitionsCount() == 0 )
+    {
+        _view_start = 0;
+        _view_end = 1;
+        return;
+    }
+    _view_start = _log->timestamp(0);
+    _view_end   = _log->timestamp( _log->transitionsCount() - 1 );
+    if( _view_end <= _view_start )
+    {
+        _view_end = _view_start + 1;
+    }
+}
+
+void ReplayTimelineWidget::clampView()
+{
+    if( !_log || _log->transitionsCount() == 0 )
+    {
+        return;
+    }
+    const double first = _log->timestamp(0);
+    const double last  = _log->timestamp( _log->transitionsCount() - 1 );
+    const double span  = _view_end - _view_start;
+
+    if( span >= last - first )
+    {
+        resetView();
+        return;
+    }
+    _view_start = std::max( first, std::min( _view_start, last - span ) );
+    _view_end = _view_start + span;
+    _full_view = false;
+}
+
+void ReplayTimelineWidget::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    painter.fillRect( rect(), palette().base() );
+
+    if( !_log || _log->transitionsCount() == 0 )
+    {
+        return;
+    }
+
+    drawTimeAxis( painter );
+
+    const int names_width = namesWidth();
+
+    for (size_t i = 0; i < _lanes.size(); i++)
+    {
+        const Lane& lane = _lanes[i];
+        const int y = AXIS_HEIGHT + static_cast<int>(i) * LANE_HEIGHT;
+        if( y > event->rect().bottom() || y + LANE_HEIGHT < event->rect().top() )
+        {
+            continue;
+        }
+        if( i % 2 == 1 )
+        {
+            painter.fillRect( 0, y, width(), LANE_HEIGHT, palette().alternateBase() );
+        }
+
+        const int indent = 4 + lane.depth * NAME_INDENT;
+        const QString name = fontMetrics().elidedText( lane.name, Qt::ElideRight,
+                                                       names_width - indent - 4 );
+        painter.setPen( palette().text().color() );
+        painter.drawText( QRect( indent, y, names_width - indent, LANE_HEIGHT ),
+                          Qt::AlignLeft | Qt::AlignVCenter, name );
+
+        painter.save();
+        painter.setClipRect( names_width, y, width() - names_width, LANE_HEIGHT );
+        drawLane( painter, lane, y );
+        painter.restore();
+    }
+
+    if( _cursor_time >= _view_start && _cursor_time <= _view_end )
+    {
+        const int x = static_cast<int>( xAt(_cursor_time) );
+        painter.setPen( QPen( QColor::fromRgb(30, 90, 220), 1 ) );
+        painter.drawLine( x, 0, x, height() );
+    }
+}
+
+void ReplayTimelineWidget::drawLane(QPainter &painter, const Lane &lane, int y) const
+{
+    const auto& rows = _log->nodeRows( lane.index );
+    if( rows.empty() )
+    {
+        return;
+    }
+    const int right = width();
+
+    auto fill = [&](int x0, int x1, NodeStatus status)
+    {
+        if( status != NodeStatus::IDLE && x1 > x0 )
+        {
+            painter.fillRect( x0, y + BAR_MARGIN, x1 - x0, LANE_HEIGHT - 2*BAR_MARGIN,
+                              statusColor(status) );
+        }
+    };
+
+    // first transition of the node in the visible range and the status before it
+    const uint32_t first_row = static_cast<uint32_t>( _log->lowerBoundRow(_view_start) );
+    size_t i = std::lower_bound( rows.begin(), rows.end(), first_row ) - rows.begin();
+    NodeStatus status = (i > 0) ? _log->status( rows[i-1] ) : NodeStatus::IDLE;
+
+    int x = namesWidth();
+    while( x < right )
+    {
+        const double next_x = (i < rows.size()) ? xAt( _log->timestamp(rows[i]) ) : right;
+        if( next_x >= right )
+        {
+            fill( x, right, status );
+            break;
+        }
+        // nothing changes until the next transition
+        const int pixel = std::max( x, static_cast<int>(next_x) );
+        fill( x, pixel, status );
+
+        // transitions that fall into the same pixel are drawn together
+        const double pixel_end = timeAt( pixel + 1 );
+        auto last = std::partition_point( rows.begin() + i, rows.end(), [&](uint32_t row)
+        {
+            return _log->timestamp(row) < pixel_end;
+        });
+        const size_t j = std::max<size_t>( i + 1, last - rows.begin() );
+
+        const NodeStatus pixel_status = (j - i == 1) ? _log->status( rows[i] )
+                                                     : worstStatus( statusMask(lane, i, j) );
+        fill( pixel, pixel + 1, pixel_status );
+
+        status = _log->status( rows[j-1] );
+        i = j;
+        x = pixel + 1;
+    }
+}
+
+void ReplayTimelineWidget::drawTimeAxis(QPainter &painter) const
+{
+    const int names_width = namesWidth();
+    const double first_timestamp = _log->timestamp(0);
+    const double pixels_per_second = std::max(1.0, double(width() - names_width)) /
+                                     (_view_end - _view_start);
+
+    // steps of 1, 2 or 5 times a power of 10
+    double step = std::pow( 10.0, std::floor( std::log10( LABEL_SPACING / pixels_per_second ) ) );
+    for (double multiplier: {2.0, 2.5, 2.0})
+    {
+        if( step * pixels_per_second >= LABEL_SPACING ) break;
+        step *= multiplier;
+    }
+    const int decimals = std::max( 0, static_cast<int>( -std::floor( std::log10(step) ) ) );
+
+    painter.setPen( palette().text().color() );
+    painter.drawLine( names_width, AXIS_HEIGHT - 1, width(), AXIS_HEIGHT - 1 );
+
+    double t = std::ceil( (_view_start - first_timestamp) / step ) * step;
+    for (; first_timestamp + t <= _view_end; t += step)
+    {
+        const int x = static_cast<int>( xAt( first_timestamp + t ) );
+        painter.drawLine( x, AXIS_HEIGHT - 5, x, AXIS_HEIGHT - 1 );
+        painter.drawText( QRect( x + 2, 0, LABEL_SPACING, AXIS_HEIGHT - 4 ),
+                          Qt::AlignLeft | Qt::AlignVCenter, QString::number( t, 'f', decimals ) );
+    }
+}
+
+void ReplayTimelineWidget::wheelEvent(QWheelEvent *event)
+{
+    // the plain wheel scrolls the lanes
+    if( !(event->modifiers() & Qt::ControlModifier) || !_log )
+    {
+        event->ignore();
+        return;
+    }
+    const double MIN_SPAN = 0.001;
+    const double anchor = timeAt( event->pos().x() );
+    const double span = _view_end - _view_start;
+    const double new_span = std::max( MIN_SPAN, span * std::pow( 1.2, -event->angleDelta().y() / 120.0 ) );
+
+    _view_start = anchor - (anchor - _view_start) * new_span / span;
+    _view_end = _view_start + new_span;
+    clampView();
+    update();
+    event->accept();
+}
+
+void ReplayTimelineWidget::mousePressEvent(QMouseEvent *event)
+{
+    if( event->button() == Qt::LeftButton )
+    {
+        _press_pos = event->pos();
+        _press_view_start = _view_start;
+        _dragging = false;
+    }
+}
+
+void ReplayTimelineWidget::mouseMoveEvent(QMouseEvent *event)
+{
+    if( !(event->buttons() & Qt::LeftButton) || !_log )
+    {
+        return;
+    }
+    const int dx = event->pos().x() - _press_pos.x();
+    if( std::abs(dx) > 3 )
+    {
+        _dragging = true;
+    }
+    if( _dragging )
+    {
+        const double span = _view_end - _view_start;
+        _view_start = _press_view_start - dx * span / std::max(1, width() - namesWidth());
+        _view_end = _view_start + span;
+        clampView();
+        update();
+    }
+}
+
+void ReplayTimelineWidget::mouseReleaseEvent(QMouseEvent *event)
+{
+    if( event->button() != Qt::LeftButton || _dragging || !_log ||
+        _log->transitionsCount() == 0 || event->pos().x() < namesWidth() )
+    {
+        _dragging = false;
+        return;
+    }
+    const double time = timeAt( event->pos().x() );
+
+    // the transition that started the bar under the mouse, if any
+    const int lane = (event->pos().y() - AXIS_HEIGHT) / LANE_HEIGHT;
+    if( event->pos().y() >= AXIS_HEIGHT && lane < static_cast<int>(_lanes.size()) )
+    {
+        const auto& rows = _log->nodeRows( _lanes[lane].index );
+        auto it = std::partition_point( rows.begin(), rows.end(), [&](uint32_t row)
+        {
+            return _log->timestamp(row) <= time;
+        });
+        if( it != rows.begin() )
+        {
+            emit rowClicked( static_cast<int>( *(it - 1) ) );
+            return;
+        }
+    }
+
+    // otherwise, the last transition before that time
+    const size_t end_row = _log->lowerBoundRow( std::nextafter( time, std::numeric_limits<double>::max() ) );
+    emit rowClicked( std::max( 0, static_cast<int>(end_row) - 1 ) );
+}
+
+void ReplayTimelineWidget::mouseDoubleClickEvent(QMouseEvent *)
+{
+    resetView();
+    update();
+}
@@ -0,0 +1,102 @@
+#ifndef REPLAY_TIMELINE_WIDGET_H
+#define REPLAY_TIMELINE_WIDGET_H
+
+#include <memory>
+#include <QWidget>
+
+#include "bt_editor_base.h"
+#include "replay_log.h"
+
+/**
+ * Gantt chart of a ReplayLog: one lane per node, with the intervals spent
+ * RUNNING, SUCCESS or FAILURE drawn as bars.
+ *
+ * When many transitions fall into the same pixel they are drawn as a single
+ * one, with the "worst" status among them (FAILURE, then RUNNING, then SUCCESS).
+ * The transitions of a node are grouped in blocks, each one storing the
+ * statuses it contains, so that zooming out doesn't require to visit all of them.
+ */
+class ReplayTimelineWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ReplayTimelineWidget(QWidget *parent = nullptr);
+
+    void setLog(std::shared_ptr<const ReplayLog> log, const AbsBehaviorTree& tree);
+
+    void clear();
+
+    // to be called when new transitions were appended to the log
+    void transitionsAppended();
+
+    // draw a cursor at the time of this row
+    void setCurrentRow(int row);
+
+    QSize sizeHint() const override;
+
+signals:
+
+    void rowClicked(int row);
+
+protected:
+
+    void paintEvent(QPaintEvent *event) override;
+
+    void wheelEvent(QWheelEvent *event) override;
+
+    void mousePressEvent(QMouseEvent *event) override;
+
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private:
+
+    struct Lane{
+        size_t index;
+        QString name;
+        int depth;
+        // one status mask every BLOCK_SIZE transitions of the node
+        std::vector<uint8_t> blocks;
+    };
+
+    void updateBlocks(Lane& lane);
+
+    // statuses of the transitions [first, last) of the posting list of the lane
+    uint8_t statusMask(const Lane& lane, size_t first, size_t last) const;
+
+    void drawLane(QPainter& painter, const Lane& lane, int y) const;
+
+    void drawTimeAxis(QPainter& painter) const;
+
+    void resetView();
+
+    // keep the visible range inside the log
+    void clampView();
+
+    int namesWidth() const;
+
+    double timeAt(double x) const;
+
+    double xAt(double time) const;
+
+    std::shared_ptr<const ReplayLog> _log;
+
+    std::vector<Lane> _lanes;
+
+    // visible time range, as absolute timestamps
+    double _view_start;
+    double _view_end;
+    bool _full_view;
+
+    double _cursor_time;
+
+    QPoint _press_pos;
+    double _press_view_start;
+    bool _dragging;
+};
+
+#endif // REPLAY_TIMELINE_WIDGET_H
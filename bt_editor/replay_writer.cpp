@@ -0,0 +1,135 @@
+#include "replay_writer.h"
+
+#include <QFile>
+#include <chrono>
+
+namespace {
+
+// the thread wakes up when this much data is pending, or periodically
+const size_t FLUSH_BYTES = 64*1024;
+const std::chrono::milliseconds FLUSH_PERIOD(200);
+
+}
+
+ReplayLogWriter::ReplayLogWriter():
+    _stop(false),
+    _error(false),
+    _records_written(0),
+    _dropped_records(0)
+{
+}
+
+ReplayLogWriter::~ReplayLogWriter()
+{
+    close();
+}
+
+void ReplayLogWriter::open(const QString &file_name, const QByteArray &header)
+{
+    close();
+
+    _pending.clear();
+    _stop = false;
+    _error_string.clear();
+    _error = false;
+    _records_written = 0;
+    _dropped_records = 0;
+    _thread = std::thread( &ReplayLogWriter::loop, this, file_name, header );
+}
+
+void ReplayLogWriter::append(const char *records, size_t count)
+{
+    const size_t bytes = count * REPLAY_RECORD_SIZE;
+    bool notify = false;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if( _pending.size() + bytes > MAX_PENDING_BYTES )
+        {
+            _dropped_records += count;
+            return;
+        }
+        _pending.insert( _pending.end(), records, records + bytes );
+        notify = _pending.size() >= FLUSH_BYTES;
+    }
+    if( notify )
+    {
+        _cv.notify_one();
+    }
+}
+
+void ReplayLogWriter::close()
+{
+    if( !_thread.joinable() )
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cv.notify_one();
+    _thread.join();
+}
+
+QString ReplayLogWriter::errorString() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _error_string;
+}
+
+void ReplayLogWriter::loop(QString file_name, QByteArray header)
+{
+    QFile file(file_name);
+    const bool opened = file.open(QIODevice::WriteOnly | QIODevice::Truncate) &&
+                        file.write( header ) == header.size();
+    if( !opened )
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _error_string = file.errorString();
+        _error = true;
+    }
+
+    std::vector<char> writing;
+    writing.reserve( FLUSH_BYTES );
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pending.reserve( FLUSH_BYTES );
+    }
+    bool stop = false;
+    while( !stop )
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv.wait_for( lock, FLUSH_PERIOD, [this]()
+            {
+                return _stop || _pending.size() >= FLUSH_BYTES;
+            });
+            stop = _stop;
+            // the caller keeps appending to the other buffer while this one is written
+            std::swap( writing, _pending );
+        }
+        if( writing.empty() )
+        {
+            continue;
+        }
+        if( !_error )
+        {
+            const qint64 size = static_cast<qint64>( writing.size() );
+            if( file.write( writing.data(), size ) != size )
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _error_string = file.errorString();
+                _error = true;
+            }
+            else{
+                _records_written += writing.size() / REPLAY_RECORD_SIZE;
+            }
+        }
+        if( _error )
+        {
+            _dropped_records += writing.size() / REPLAY_RECORD_SIZE;
+        }
+        writing.clear();
+    }
+    file.close();
+}
@@ -0,0 +1,74 @@
+#ifndef REPLAY_WRITER_H
+#define REPLAY_WRITER_H
+
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "replay_format.h"
+
+/**
+ * Writes a .fbl log from a separate thread, so that the caller never waits
+ * for the disk. Records are appended to a buffer in memory and flushed
+ * periodically by the writer thread.
+ *
+ * If the disk can't keep up and the buffer reaches MAX_PENDING_BYTES, new
+ * records are dropped (see droppedRecords()) rather than growing the memory.
+ */
+class ReplayLogWriter
+{
+public:
+
+    static const size_t MAX_PENDING_BYTES = 64*1024*1024;
+
+    ReplayLogWriter();
+
+    ~ReplayLogWriter();
+
+    // Start the writer thread. The file is created by the thread:
+    // if that fails, hasError() becomes true.
+    // header as in a .fbl file: 4 bytes with the size of the flatbuffer, then the flatbuffer
+    void open(const QString& file_name, const QByteArray& header);
+
+    // "count" records, 12 bytes each, as in a .fbl file
+    void append(const char* records, size_t count);
+
+    // write what is left and stop the thread
+    void close();
+
+    bool isOpen() const { return _thread.joinable(); }
+
+    bool hasError() const { return _error; }
+
+    // thread-safe copy of the error message
+    QString errorString() const;
+
+    size_t recordsWritten() const { return _records_written; }
+
+    // records appended but not written: the buffer was full, or the file failed
+    size_t droppedRecords() const { return _dropped_records; }
+
+private:
+
+    void loop(QString file_name, QByteArray header);
+
+    std::thread _thread;
+    mutable std::mutex _mutex;
+    std::condition_variable _cv;
+
+    // protected by _mutex. A vector keeps its capacity when cleared:
+    // the two buffers are not reallocated at every flush
+    std::vector<char> _pending;
+    bool _stop;
+    QString _error_string;
+
+    std::atomic<bool> _error;
+    std::atomic<size_t> _records_written;
+    std::atomic<size_t> _dropped_records;
+};
+
+#endif // REPLAY_WRITER_H
@@ -6,6 +6,11 @@
 #include <QTimer>
 #include <QLabel>
 #include <QDebug>
+#include <QDir>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QSettings>
+#include <QSignalBlocker>
 
 #include "mainwindow.h"
 #include "utils.h"
@@ -14,19 +19,21 @@ SidepanelMonitor::SidepanelMonitor(QWidget *parent) :
     QFrame(parent),
     ui(new Ui::SidepanelMonitor),
     _zmq_context(1),
-    _zmq_subscriber(_zmq_context, ZMQ_SUB),
     _connected(false),
-    _msg_count(0),
     _parent(parent)
 {
     ui->setupUi(this);
     _timer = new QTimer(this);
+    _stats_timer = new QTimer(this);
 
     connect( _timer, &QTimer::timeout, this, &SidepanelMonitor::on_timer );
+    connect( _stats_timer, &QTimer::timeout, this, &SidepanelMonitor::updateStatistics );
 }
 
 SidepanelMonitor::~SidepanelMonitor()
 {
+    // the connections must be closed before the context
+    _connections.clear();
     delete ui;
 }
 
@@ -39,150 +46,259 @@ void SidepanelMonitor::on_timer()
 {
     if( !_connected ) return;
 
-    zmq::message_t msg;
-    try{
-        while(  _zmq_subscriber.recv(&msg) )
+    auto main_win = dynamic_cast<MainWindow*>( _parent );
+
+    // the robots that are not in the current tab are not drawn
+    const GraphicContainer* visible_tab = main_win->currentTabInfo();
+    bool painted_any = false;
+
+    for (const auto& it: _connections)
+    {
+        MonitorConnection* connection = it.get();
+        const bool visible = visible_tab &&
+                main_win->getTabByName( connection->treeName() ) == visible_tab;
+
+        bool painted = false;
+        connection->processMessages( visible, &painted );
+        painted_any = painted_any || painted;
+
+        if( connection->writer().isOpen() )
         {
-            _msg_count++;
-            ui->labelCount->setText( QString("Messages received: %1").arg(_msg_count) );
-
-            const char* buffer = reinterpret_cast<const char*>(msg.data());
-
-            const uint32_t header_size = flatbuffers::ReadScalar<uint32_t>( buffer );
-            const uint32_t num_transitions = flatbuffers::ReadScalar<uint32_t>( &buffer[4+header_size] );
-            
-            std::vector<std::pair<int, NodeStatus>> node_status;
-            // check uid in the index, if failed load tree from server
-            try{
-                for(size_t offset = 4; offset < header_size +4; offset +=3 )
-                {
-                    const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset]);
-                    _uid_to_index.at(uid);
-                }
-                
-                for(size_t t=0; t < num_transitions; t++)
-                {
-                    size_t offset = 8 + header_size + 12*t;
-                    const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset+8]);
-                    _uid_to_index.at(uid);
-                }
-
-                for(size_t offset = 4; offset < header_size +4; offset +=3 )
-                {
-                    const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset]);
-                    const uint16_t index = _uid_to_index.at(uid);
-                    AbstractTreeNode* node = _loaded_tree.node( index );
-                    node->status = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[offset+2] ));
-                }
-
-                //qDebug() << "--------";
-                for(size_t t=0; t < num_transitions; t++)
-                {
-                    size_t offset = 8 + header_size + 12*t;
-
-                    // const double t_sec  = flatbuffers::ReadScalar<uint32_t>( &buffer[offset] );
-                    // const double t_usec = flatbuffers::ReadScalar<uint32_t>( &buffer[offset+4] );
-                    // double timestamp = t_sec + t_usec* 0.000001;
-                    const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset+8]);
-                    const uint16_t index = _uid_to_index.at(uid);
-                    // NodeStatus prev_status = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[index+10] ));
-                    NodeStatus status  = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[offset+11] ));
-
-                    _loaded_tree.node(index)->status = status;
-                    node_status.push_back( {index, status} );
-
-                }
+            if( connection->writer().hasError() )
+            {
+                stopRecording( connection, connection->writer().errorString() );
             }
-            catch( std::out_of_range& err) {
-                qDebug() << "Reload tree from server";
-                if( !getTreeFromServer() ) {
-                    _connected = false;
-                    ui->lineEdit->setDisabled(false);
-                    _timer->stop();
-                    connectionUpdate(false);
-                    return;
-                }
+            else if( connection == currentConnection() ){
+                updateRecordLabel();
             }
-
-            // update the graphic part
-            emit changeNodeStyle( "BehaviorTree", node_status );
-
-            // lock editing of nodes
-            auto main_win = dynamic_cast<MainWindow*>( _parent );
-            main_win->lockEditing(true);
         }
     }
-    catch( zmq::error_t& err)
+
+    if( painted_any )
     {
-        qDebug() << "ZMQ receive failed: " << err.what();
+        // lock editing of nodes
+        main_win->lockEditing(true);
     }
 }
 
-bool SidepanelMonitor::getTreeFromServer()
+void SidepanelMonitor::updateStatistics()
 {
-    try{
-        zmq::message_t request(0);
-        zmq::message_t reply;
+    MonitorConnection* current = currentConnection();
 
-        zmq::socket_t  zmq_client( _zmq_context, ZMQ_REQ );
-        zmq_client.connect( _connection_address_req.c_str() );
+    // the window of all the connections is restarted, even if only one is shown
+    for (size_t i = 0; i < _connections.size(); i++)
+    {
+        const auto& connection = _connections[i];
+        const MonitorConnection::Statistics stats = connection->takeStatistics();
+        if( connection.get() == current )
+        {
+            showStatistics( *connection, stats );
+        }
 
-        int timeout_ms = 1000;
-        zmq_client.setsockopt(ZMQ_RCVTIMEO,&timeout_ms, sizeof(int) );
+        QString item_text = connection->treeName();
+        switch( connection->state() )
+        {
+        case MonitorConnection::State::WAITING_TREE: item_text += tr(" (waiting)"); break;
+        case MonitorConnection::State::STALE:        item_text += tr(" (stale)"); break;
+        case MonitorConnection::State::CONNECTED: break;
+        }
+        ui->comboBoxRobot->setItemText( static_cast<int>(i), item_text );
+    }
+}
 
-        zmq_client.send(request);
+QString SidepanelMonitor::stateDescription(const MonitorConnection &connection) const
+{
+    switch( connection.state() )
+    {
+    case MonitorConnection::State::WAITING_TREE:
+        if( connection.failedRequests() == 0 )
+        {
+            return tr("Waiting for the tree");
+        }
+        return tr("Waiting for the tree (%1 attempts failed: %2)")
+                .arg( connection.failedRequests() ).arg( connection.errorString() );
 
-        bool received = zmq_client.recv(&reply);
-        if( ! received )
+    case MonitorConnection::State::STALE:
+        if( connection.isReloadingTree() )
         {
-            return false;
+            return tr("Stale: reloading the tree");
         }
+        return tr("Stale: no messages for %1 s").arg( connection.silenceTime() / 1000 );
 
-        const char* buffer = reinterpret_cast<const char*>(reply.data());
-        auto fb_behavior_tree = Serialization::GetBehaviorTree( buffer );
+    case MonitorConnection::State::CONNECTED:
+        return tr("Connected");
+    }
+    return QString();
+}
 
-        auto res_pair = BuildTreeFromFlatbuffers( fb_behavior_tree );
+void SidepanelMonitor::showStatistics(const MonitorConnection& connection,
+                                      const MonitorConnection::Statistics& stats)
+{
+    ui->labelCount->setText( QString("Messages received: %1").arg( connection.messagesCount() ) );
+    ui->labelState->setText( stateDescription( connection ) );
 
-        _loaded_tree  = std::move( res_pair.first );
-        _uid_to_index = std::move( res_pair.second );
+    if( stats.elapsed > 0 )
+    {
+        ui->labelMessagesRate->setText( QString::number( stats.messages / stats.elapsed, 'f', 0 ) );
+        ui->labelTransitionsRate->setText( QString::number( stats.transitions / stats.elapsed, 'f', 0 ) );
+    }
+    else{
+        ui->labelMessagesRate->setText( "-" );
+        ui->labelTransitionsRate->setText( "-" );
+    }
 
-        // add new models to registry
-        for(const auto& tree_node: _loaded_tree.nodes())
-        {
-            const auto& registration_ID = tree_node.model.registration_ID;
-            if( BuiltinNodeModels().count(registration_ID) == 0)
-            {
-                addNewModel( tree_node.model );
-            }
-        }
+    if( stats.latency.count() > 0 )
+    {
+        ui->labelLatency->setText( QString("%1 / %2 / %3 ms")
+                                   .arg( stats.latency.mean() * 1000.0, 0, 'f', 1 )
+                                   .arg( stats.latency.percentile(0.99) * 1000.0, 0, 'f', 1 )
+                                   .arg( stats.latency.max() * 1000.0, 0, 'f', 1 ) );
+    }
+    else{
+        ui->labelLatency->setText( "-" );
+    }
+    ui->labelQueue->setText( QString("%1 / %2").arg( connection.queueSize() ).arg( stats.queue_max ) );
+    ui->labelDropped->setText( QString("%1 / %2").arg( connection.droppedMessages() )
+                                                 .arg( connection.malformedMessages() ) );
+    ui->labelMerged->setText( QString::number( connection.conflatedCount() ) );
+}
 
-        try {
-            loadBehaviorTree( _loaded_tree, "BehaviorTree" );
-        }
-        catch (std::exception& err) {
-            QMessageBox messageBox;
-            messageBox.critical(this,"Error Connecting to remote server", err.what() );
-            messageBox.show();
-            return false;
-        }
+void SidepanelMonitor::on_comboBoxRobot_currentIndexChanged(int index)
+{
+    Q_UNUSED(index);
+    MonitorConnection* connection = currentConnection();
+
+    const QSignalBlocker blocker( ui->pushButtonRecord );
+    ui->pushButtonRecord->setChecked( connection && connection->writer().isOpen() );
+    ui->labelRecord->clear();
+    ui->labelRecord->setToolTip( QString() );
 
-        std::vector<std::pair<int, NodeStatus>> node_status;
-        node_status.reserve(_loaded_tree.nodesCount());
+    if( connection )
+    {
+        // the rates are shown at the next update
+        showStatistics( *connection, MonitorConnection::Statistics() );
+        updateRecordLabel();
+    }
+}
 
-        //  qDebug() << "--------";
+MonitorConnection *SidepanelMonitor::currentConnection()
+{
+    const int index = ui->comboBoxRobot->currentIndex();
+    if( index < 0 || static_cast<size_t>(index) >= _connections.size() )
+    {
+        return nullptr;
+    }
+    return _connections[ static_cast<size_t>(index) ].get();
+}
 
-        for(size_t t=0; t < _loaded_tree.nodesCount(); t++)
-        {
-            node_status.push_back( { t, _loaded_tree.nodes()[t].status } );
-        }
-        emit changeNodeStyle( "BehaviorTree", node_status );
+void SidepanelMonitor::setConnected(bool connected)
+{
+    _connected = connected;
+    ui->lineEdit->setDisabled(connected);
+    ui->lineEdit_publisher->setDisabled(connected);
+    ui->pushButtonRecord->setEnabled(connected);
+    ui->comboBoxRobot->setEnabled(connected);
+
+    if( connected )
+    {
+        _timer->start(20);
+        _stats_timer->start(1000);
+    }
+    else{
+        _timer->stop();
+        _stats_timer->stop();
+    }
+    connectionUpdate(connected);
+}
+
+void SidepanelMonitor::on_pushButtonRecord_toggled(bool checked)
+{
+    MonitorConnection* connection = currentConnection();
+    if( !connection )
+    {
+        return;
     }
-    catch( zmq::error_t& err)
+    if( !checked )
     {
-        qDebug() << "ZMQ client receive failed: " << err.what();
-        return false;
+        stopRecording( connection );
+        return;
     }
-    return true;
+    if( connection->state() == MonitorConnection::State::WAITING_TREE )
+    {
+        // the log starts with the tree
+        const QSignalBlocker blocker( ui->pushButtonRecord );
+        ui->pushButtonRecord->setChecked(false);
+        ui->labelRecord->setText( tr("The tree was not received yet") );
+        return;
+    }
+
+    QSettings settings;
+    QString directory_path  = settings.value("SidepanelMonitor.lastRecordDirectory",
+                                             QDir::homePath() ).toString();
+
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Record [%1] to").arg( connection->treeName() ),
+                                                    directory_path,
+                                                    tr("Flatbuffers log (*.fbl)"));
+    if( fileName.isEmpty() )
+    {
+        const QSignalBlocker blocker( ui->pushButtonRecord );
+        ui->pushButtonRecord->setChecked(false);
+        return;
+    }
+    if (!fileName.endsWith(".fbl"))
+    {
+        fileName += ".fbl";
+    }
+    directory_path = QFileInfo(fileName).absolutePath();
+    settings.setValue("SidepanelMonitor.lastRecordDirectory", directory_path);
+
+    connection->startRecording( fileName );
+    updateRecordLabel();
+}
+
+void SidepanelMonitor::stopRecording(MonitorConnection* connection, const QString& reason)
+{
+    const ReplayLogWriter& writer = connection->writer();
+    if( !writer.isOpen() )
+    {
+        return;
+    }
+    // waits for the pending transitions to be written
+    connection->stopRecording();
+
+    QString message = tr("Saved %1 transitions").arg( writer.recordsWritten() );
+    if( writer.droppedRecords() > 0 )
+    {
+        message += tr(" (%1 lost)").arg( writer.droppedRecords() );
+    }
+
+    if( connection == currentConnection() )
+    {
+        const QSignalBlocker blocker( ui->pushButtonRecord );
+        ui->pushButtonRecord->setChecked(false);
+        ui->labelRecord->setText( message );
+        ui->labelRecord->setToolTip( connection->recordFileName() );
+    }
+
+    if( writer.hasError() || !reason.isEmpty() )
+    {
+        QMessageBox::warning(this, tr("Recording stopped"),
+                             tr("Recording to [%1] stopped: %2")
+                             .arg( connection->recordFileName(),
+                                   writer.hasError() ? writer.errorString() : reason ),
+                             QMessageBox::Close);
+    }
+}
+
+void SidepanelMonitor::updateRecordLabel()
+{
+    MonitorConnection* connection = currentConnection();
+    if( !connection || !connection->writer().isOpen() )
+    {
+        return;
+    }
+    ui->labelRecord->setText( tr("Recording: %1 transitions").arg( connection->writer().recordsWritten() ) );
+    ui->labelRecord->setToolTip( connection->recordFileName() );
 }
 
 void SidepanelMonitor::on_Connect()
@@ -206,59 +322,88 @@ void SidepanelMonitor::on_Connect()
         QString server_port = ui->lineEdit_server->text();
         if( server_port.isEmpty() )
         {
-          publisher_port = ui->lineEdit_server->placeholderText();
-          ui->lineEdit_server->setText(publisher_port);
+          server_port = ui->lineEdit_server->placeholderText();
+          ui->lineEdit_server->setText(server_port);
         }
 
-        bool failed = false;
-        if( !address.isEmpty() )
+        // "host" or "host:publisher_port:server_port", separated by commas
+        QStringList robots;
+        for (const QString& robot: address.split(',', QString::SkipEmptyParts))
         {
-            _connection_address_pub = "tcp://" + address.toStdString() + ":" + publisher_port.toStdString();
-            _connection_address_req = "tcp://" + address.toStdString() + ":" + server_port.toStdString();
-
-            try{
-                _zmq_subscriber.connect( _connection_address_pub.c_str() );
-
-                int timeout_ms = 1;
-                _zmq_subscriber.setsockopt(ZMQ_SUBSCRIBE, "", 0);
-                _zmq_subscriber.setsockopt(ZMQ_RCVTIMEO,&timeout_ms, sizeof(int) );
+            if( !robot.trimmed().isEmpty() && !robots.contains( robot.trimmed() ) )
+            {
+                robots.push_back( robot.trimmed() );
+            }
+        }
 
-                if( !getTreeFromServer() )
-                {
-                    failed = true;
-                    _connected = false;
-                }
+        QStringList failures;
+        for (const QString& robot: robots)
+        {
+            const QStringList parts = robot.split(':');
+            if( parts.size() != 1 && parts.size() != 3 )
+            {
+                failures.push_back( tr("[%1]: not a valid address").arg(robot) );
+                continue;
             }
-            catch(zmq::error_t& err)
+            const std::string host = parts[0].toStdString();
+            const std::string address_pub = "tcp://" + host + ":" +
+                    ( parts.size() == 3 ? parts[1] : publisher_port ).toStdString();
+            const std::string address_req = "tcp://" + host + ":" +
+                    ( parts.size() == 3 ? parts[2] : server_port ).toStdString();
+
+            // a single robot is shown in the usual tab
+            const QString tree_name = robots.size() == 1 ? QString("BehaviorTree") : robot;
+
+            std::unique_ptr<MonitorConnection> connection( new MonitorConnection( _zmq_context, tree_name ) );
+
+            connect( connection.get(), &MonitorConnection::loadBehaviorTree,
+                     this, &SidepanelMonitor::loadBehaviorTree );
+            connect( connection.get(), &MonitorConnection::changeNodeStyle,
+                     this, &SidepanelMonitor::changeNodeStyle );
+            connect( connection.get(), &MonitorConnection::addNewModel,
+                     this, &SidepanelMonitor::addNewModel );
+
+            MonitorConnection* connection_ptr = connection.get();
+            connect( connection_ptr, &MonitorConnection::recordingInterrupted,
+                     this, [this, connection_ptr](const QString& reason)
+            {
+                stopRecording( connection_ptr, reason );
+            });
+
+            if( !connection->open( address_pub, address_req ) )
             {
-                failed = true;
+                failures.push_back( tr("[%1]: %2").arg( address_pub.c_str(), connection->errorString() ) );
+                continue;
             }
-        }
-        else {
-            failed = true;
+            _connections.push_back( std::move(connection) );
+            ui->comboBoxRobot->addItem( tree_name );
         }
 
-        if( !failed )
+        if( !failures.isEmpty() )
         {
-            _connected = true;
-            ui->lineEdit->setDisabled(true);
-            ui->lineEdit_publisher->setDisabled(true);
-            _timer->start(20);
-            connectionUpdate(true);
-        }
-        else{
             QMessageBox::warning(this,
                                  tr("ZeroMQ connection"),
-                                 tr("Was not able to connect to [%1]\n").arg(_connection_address_pub.c_str()),
+                                 tr("Was not able to connect to:\n%1\n").arg( failures.join("\n") ),
                                  QMessageBox::Close);
         }
+        if( !_connections.empty() )
+        {
+            setConnected(true);
+        }
     }
     else{
-        _connected = false;
-        ui->lineEdit->setDisabled(false);
-        ui->lineEdit_publisher->setDisabled(false);
-        _timer->stop();
+        // show the final numbers of the selected robot
+        updateStatistics();
 
-        connectionUpdate(false);
+        for (const auto& connection: _connections)
+        {
+            stopRecording( connection.get() );
+        }
+        _connections.clear();
+        {
+            const QSignalBlocker blocker( ui->comboBoxRobot );
+            ui->comboBoxRobot->clear();
+        }
+        setConnected(false);
     }
 }
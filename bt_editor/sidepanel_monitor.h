@@ -2,9 +2,12 @@
 #define SIDEPANEL_MONITOR_H
 
 #include <QFrame>
+#include <memory>
+#include <vector>
 #include <zmq.hpp>
 
 #include "bt_editor_base.h"
+#include "monitor_connection.h"
 
 namespace Ui {
 class SidepanelMonitor;
@@ -28,6 +31,12 @@ private slots:
 
     void on_timer();
 
+    void on_pushButtonRecord_toggled(bool checked);
+
+    void on_comboBoxRobot_currentIndexChanged(int index);
+
+    void updateStatistics();
+
 signals:
     void loadBehaviorTree(const AbsBehaviorTree& tree, const QString &bt_name );
 
@@ -41,18 +50,28 @@ signals:
 private:
     Ui::SidepanelMonitor *ui;
 
+    // shared by all the connections
     zmq::context_t _zmq_context;
-    zmq::socket_t  _zmq_subscriber;
+    // one per robot, in the same order of comboBoxRobot
+    std::vector<std::unique_ptr<MonitorConnection>> _connections;
 
     bool _connected;
-    std::string _connection_address_pub;
-    std::string _connection_address_req;
     QTimer* _timer;
-    int _msg_count;
-    AbsBehaviorTree _loaded_tree;
-    std::unordered_map<int, int> _uid_to_index;
+    QTimer* _stats_timer;
+
+    // the robot selected in comboBoxRobot, nullptr if there are none
+    MonitorConnection* currentConnection();
+
+    void setConnected(bool connected);
+
+    QString stateDescription(const MonitorConnection& connection) const;
+
+    void showStatistics(const MonitorConnection& connection,
+                        const MonitorConnection::Statistics& stats);
+
+    void stopRecording(MonitorConnection* connection, const QString& reason = QString());
 
-    bool getTreeFromServer();
+    void updateRecordLabel();
 
     QWidget *_parent;
 
@@ -1,50 +1,90 @@
 #include "sidepanel_replay.h"
 #include "ui_sidepanel_replay.h"
 
+#include <atomic>
+#include <cmath>
+#include <limits>
 #include <QDir>
 #include <QFile>
 #include <QtConcurrent/QtConcurrentRun>
+#include <QFutureWatcher>
+#include <QProgressDialog>
 #include <QFileInfo>
 #include <QFileDialog>
 #include <QSettings>
 #include <QKeyEvent>
-#include <QStandardItem>
 #include <QModelIndex>
 #include <QTimer>
 #include <QMessageBox>
+#include <QSortFilterProxyModel>
+#include <QMenu>
 
 #include "bt_editor_base.h"
 #include "mainwindow.h"
+#include "replay_compare_dialog.h"
 #include "utils.h"
 
+namespace {
+
+// milliseconds between two frames of the playback, about 30 Hz
+const int PLAY_FRAME_PERIOD = 33;
+
+bool sameState(const ReplayLog::NodeState& a, const ReplayLog::NodeState& b)
+{
+    return a.status == b.status && a.prev_status == b.prev_status;
+}
+
+}
 
 SidepanelReplay::SidepanelReplay(QWidget *parent) :
     QFrame(parent),
     ui(new Ui::SidepanelReplay),
     _prev_row(-1),
+    _play_time(0),
+    _play_speed(1.0),
+    _statistics_shown_count(0),
     _parent(parent)
 {
     ui->setupUi(this);
 
-    _table_model = new QStandardItemModel(0,4, this);
+    _table_model = new ReplayTableModel(this);
 
-    _table_model->setHeaderData(0,Qt::Horizontal, "Time");
-    _table_model->setHeaderData(1,Qt::Horizontal, "Node Name");
-    _table_model->setHeaderData(2,Qt::Horizontal, "Previous");
-    _table_model->setHeaderData(3,Qt::Horizontal, "Status");
+    _filter_model = new ReplayFilterModel(this);
+    _filter_model->setSourceModel(_table_model);
 
-    ui->tableView->setModel(_table_model);
+    ui->tableView->setModel(_filter_model);
     ui->tableView->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
 
+    _statistics_model = new ReplayStatisticsModel(this);
+
+    auto statistics_sort_model = new QSortFilterProxyModel(this);
+    statistics_sort_model->setSourceModel(_statistics_model);
+    statistics_sort_model->setSortRole(Qt::UserRole);
+
+    ui->tableViewStatistics->setModel(statistics_sort_model);
+    ui->tableViewStatistics->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    ui->tableViewStatistics->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+
+    _timeline = new ReplayTimelineWidget();
+    ui->scrollAreaTimeline->setWidget(_timeline);
+    connect( _timeline, &ReplayTimelineWidget::rowClicked, this, &SidepanelReplay::onTimelineClicked );
+
+    auto slowest_menu = new QMenu(this);
+    ui->toolButtonSlowest->setMenu( slowest_menu );
+    connect( slowest_menu, &QMenu::aboutToShow, this, &SidepanelReplay::onSlowestTicksMenu );
+
     _layout_update_timer = new QTimer(this);
     _layout_update_timer->setSingleShot(true);
     connect( _layout_update_timer, &QTimer::timeout, this, &SidepanelReplay::onTimerUpdate );
 
 
     _play_timer = new QTimer(this);
-    _play_timer->setSingleShot(true);
     connect( _play_timer, &QTimer::timeout, this, &SidepanelReplay::onPlayUpdate );
 
+    // polling works also when the file is written through a network mount
+    _follow_timer = new QTimer(this);
+    connect( _follow_timer, &QTimer::timeout, this, &SidepanelReplay::onFollowUpdate );
+
     ui->tableView->installEventFilter(this);
 }
 
@@ -55,80 +95,20 @@ SidepanelReplay::~SidepanelReplay()
 
 void SidepanelReplay::clear()
 {
-    _table_model->setColumnCount(4);
-    _table_model->setRowCount(0);
+    _table_model->clear();
+    _statistics_model->clear();
+    _timeline->clear();
+    _displayed_state.clear();
 }
 
 void SidepanelReplay::updateTableModel(const AbsBehaviorTree& locaded_tree)
 {
-    _table_model->setColumnCount(4);
-    _table_model->setRowCount(0);
-
-    const size_t transitions_count = _transitions.size();
-
-    auto createStatusItem = [](NodeStatus status) -> QStandardItem*
-    {
-        QStandardItem* item = nullptr;
-        switch (status)
-        {
-        case NodeStatus::SUCCESS:{
-            item = new QStandardItem("SUCCESS");
-            item->setBackground(QColor::fromRgb(22, 255, 22));
-        } break;
-        case NodeStatus::FAILURE:{
-            item = new QStandardItem("FAILURE");
-            item->setBackground(QColor::fromRgb(255, 22, 22));
-        } break;
-        case NodeStatus::RUNNING:{
-            item = new QStandardItem("RUNNING");
-            item->setBackground(QColor::fromRgb(250, 160, 20));
-        } break;
-        case NodeStatus::IDLE:{
-            item = new QStandardItem("IDLE");
-            item->setBackground(QColor::fromRgb(222, 222, 222));
-        } break;
-        }
-        item->setForeground(QColor::fromRgb(0, 0, 0));
-        return item;
-    };
+    _table_model->setLog( _log, locaded_tree );
+    _filter_model->setLog( _log, locaded_tree );
+    _timeline->setLog( _log, locaded_tree );
 
-    if(  transitions_count > 0)
+    if( transitionsCount() > 0)
     {
-        double previous_timestamp = 0;
-        const double first_timestamp = _transitions.front().timestamp;
-
-        for(size_t row=0; row < transitions_count; row++)
-        {
-            auto& trans = _transitions[row];
-            auto node  = locaded_tree.node( trans.index );
-
-            QString timestamp;
-            timestamp.sprintf("%.3f", trans.timestamp - first_timestamp);
-
-            auto timestamp_item = new QStandardItem( timestamp );
-            timestamp.sprintf("absolute time: %.3f", trans.timestamp);
-            timestamp_item->setToolTip( timestamp );
-
-            if(  (trans.timestamp - previous_timestamp) >= 0.001 || row == transitions_count-1)
-            {
-                _timepoint.push_back( {trans.timestamp, row}  );
-                previous_timestamp = trans.timestamp;
-
-                auto font = timestamp_item->font();
-                font.setBold(true);
-                timestamp_item->setFont(font);
-            }
-
-            QList<QStandardItem *> rowData;
-            rowData << timestamp_item;
-            rowData << new QStandardItem( node->instance_name );
-            rowData << createStatusItem( trans.prev_status );
-            rowData << createStatusItem( trans.status );
-            _table_model->appendRow(rowData);
-        }
-
-        emit _table_model->dataChanged( _table_model->index(0,0), _table_model->index( transitions_count-1, 3) );
-
         ui->tableView->horizontalHeader()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
         ui->tableView->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
         ui->tableView->horizontalHeader()->setSectionResizeMode(2, QHeaderView::ResizeToContents);
@@ -136,15 +116,31 @@ void SidepanelReplay::updateTableModel(const AbsBehaviorTree& locaded_tree)
         ui->tableView->verticalHeader()->minimumSize();
     }
 
-    ui->label->setText( QString("of %1").arg( _timepoint.size() ) );
-
     ui->spinBox->setValue(0);
-    ui->spinBox->setMaximum( std::max(0 , (int)_timepoint.size()-1) );
-    ui->spinBox->setEnabled( !_timepoint.empty() );
     ui->timeSlider->setValue( 0 );
-    ui->timeSlider->setMaximum( std::max(0 , (int)_timepoint.size()-1) );
-    ui->timeSlider->setEnabled( !_timepoint.empty() );
-    ui->pushButtonPlay->setEnabled( !_timepoint.empty() );
+    updateTimeRange();
+}
+
+void SidepanelReplay::updateTimeRange()
+{
+    const auto& timepoints = _log->timepoints();
+    const bool enabled = !timepoints.empty() && !ui->pushButtonPlay->isChecked();
+
+    ui->label->setText( QString("of %1").arg( timepoints.size() ) );
+
+    ui->spinBox->setMaximum( std::max(0 , (int)timepoints.size()-1) );
+    ui->spinBox->setEnabled( enabled );
+    ui->timeSlider->setMaximum( std::max(0 , (int)timepoints.size()-1) );
+    ui->timeSlider->setEnabled( enabled );
+    ui->pushButtonPlay->setEnabled( !timepoints.empty() );
+
+    const int ticks = static_cast<int>( _log->ticksCount() );
+    ui->labelTicks->setText( QString("of %1 ticks").arg( ticks ) );
+    ui->spinBoxTick->setMaximum( std::max(0, ticks - 1) );
+    ui->spinBoxTick->setEnabled( enabled );
+    ui->pushButtonPrevTick->setEnabled( enabled );
+    ui->pushButtonNextTick->setEnabled( enabled );
+    ui->toolButtonSlowest->setEnabled( enabled );
 }
 
 void SidepanelReplay::on_LoadLog()
@@ -155,72 +151,166 @@ void SidepanelReplay::on_LoadLog()
 
     QString fileName = QFileDialog::getOpenFileName(this,
                                                     tr("Open Flow Scene"), directory_path,
-                                                    tr("Flatbuffers log (*.fbl)"));
+                                                    tr("Flatbuffers log (*.fbl *.fblz)"));
 
     if (fileName.isEmpty() || !QFileInfo::exists(fileName))
     {
         return;
     }
-    QFile file(fileName);
-
-    if (!file.open(QIODevice::ReadOnly)){
-        return;
-    }
-
     directory_path = QFileInfo(fileName).absolutePath();
     settings.setValue("SidepanelReplay.lastLoadDirectory", directory_path);
     settings.sync();
 
-    QByteArray content = file.readAll();
-    loadLog( content );
+    loadLogFile( fileName );
+}
+
+void SidepanelReplay::loadLogFile(const QString &file_name)
+{
+    decodeLogFile( file_name, nullptr, [this](const DecodedLog& decoded)
+    {
+        openLog( decoded );
+    });
+}
+
+void SidepanelReplay::decodeLogFile(const QString &file_name,
+                                    std::shared_ptr<const ReplayLog> compare_with,
+                                    std::function<void(const DecodedLog&)> on_decoded)
+{
+    const int PROGRESS_STEPS = 1000;
+
+    auto progress_dialog = new QProgressDialog( tr("Loading %1").arg( QFileInfo(file_name).fileName() ),
+                                                tr("Cancel"), 0, PROGRESS_STEPS, this );
+    progress_dialog->setWindowModality( Qt::WindowModal );
+    progress_dialog->setMinimumDuration( 500 );
+    progress_dialog->setAutoClose( false );
+    progress_dialog->setAutoReset( false );
+
+    // shared with the worker thread
+    auto canceled = std::make_shared<std::atomic<bool>>(false);
+    auto progress_value = std::make_shared<std::atomic<int>>(0);
+
+    connect( progress_dialog, &QProgressDialog::canceled, this, [canceled]()
+    {
+        *canceled = true;
+    });
+
+    // the dialog is refreshed by the GUI thread, the worker only writes progress_value
+    auto progress_timer = new QTimer( progress_dialog );
+    connect( progress_timer, &QTimer::timeout, progress_dialog, [progress_dialog, progress_value]()
+    {
+        progress_dialog->setValue( *progress_value );
+    });
+    progress_timer->start(100);
+
+    auto progress = [canceled, progress_value](size_t done, size_t total) -> bool
+    {
+        *progress_value = static_cast<int>( (done * PROGRESS_STEPS) / std::max<size_t>(1, total) );
+        return !(*canceled);
+    };
+
+    auto watcher = new QFutureWatcher<DecodedLog>(this);
+    connect( watcher, &QFutureWatcher<DecodedLog>::finished, this, [watcher, progress_dialog, on_decoded]()
+    {
+        progress_dialog->close();
+        progress_dialog->deleteLater();
+        watcher->deleteLater();
+        on_decoded( watcher->result() );
+    });
+
+    watcher->setFuture( QtConcurrent::run( [file_name, progress, compare_with]()
+    {
+        auto log = std::make_shared<ReplayLog>();
+        log->openFile( file_name );
+        DecodedLog decoded = decodeLog( log, progress );
+        decoded.file_name = file_name;
+
+        if( compare_with && decoded.error == ReplayLog::Error::NONE )
+        {
+            decoded.diff = CompareReplayLogs( *compare_with, *log );
+        }
+        return decoded;
+    }) );
 }
 
 void SidepanelReplay::loadLog(const QByteArray &content)
 {
-    const char* buffer = reinterpret_cast<const char*>(content.data());
+    auto log = std::make_shared<ReplayLog>();
+    log->openBuffer( content );
+    openLog( decodeLog( log, ReplayLog::ProgressCallback() ) );
+}
+
+SidepanelReplay::DecodedLog SidepanelReplay::decodeLog(std::shared_ptr<ReplayLog> log,
+                                                       const ReplayLog::ProgressCallback& progress)
+{
+    DecodedLog decoded;
+
+    if( log->error() == ReplayLog::Error::NONE )
+    {
+        log->buildIndex( progress );
+    }
+    decoded.error = log->error();
+
+    if( decoded.error == ReplayLog::Error::NONE )
+    {
+        decoded.statistics = std::make_shared<ReplayStatistics>();
+        if( !decoded.statistics->process( *log, progress ) )
+        {
+            decoded.error = ReplayLog::Error::CANCELED;
+        }
+    }
+
+    if( decoded.error == ReplayLog::Error::NONE )
+    {
+        decoded.tree = BuildTreeFromFlatbuffers( log->behaviorTree() ).first;
+        decoded.log = log;
+    }
+    return decoded;
+}
+
+bool SidepanelReplay::checkLogError(ReplayLog::Error error)
+{
+    switch( error )
+    {
+    case ReplayLog::Error::NONE: return true;
+
+    case ReplayLog::Error::CANCELED: return false;
 
-    // how many bytes did we read off the disk (uoffset_t aka uint32_t)
-    const auto read_bytes = content.size();
+    case ReplayLog::Error::CANT_OPEN:
+        QMessageBox::warning( this, "Can't open the Log file",
+                             "Failed to load this file.\n"
+                             "It can not be opened for reading");
+        return false;
 
-    // we need at least 4 bytes to read the bt_header_size
-    if( read_bytes < 4 ) {
+    case ReplayLog::Error::EMPTY:
         QMessageBox::warning( this, "Log file is empty",
                              "Failed to load this file.\n"
                              "This Log file is empty");
-        return;
-    }
-    
-    // read the length of the header section from the file
-    const size_t bt_header_size = flatbuffers::ReadScalar<uint32_t>(buffer);
+        return false;
 
-    // if the length of the header goes past the end of the file, it is invalid
-    if( (bt_header_size == 0) || (bt_header_size > read_bytes) ) {
+    case ReplayLog::Error::CORRUPTED:
         QMessageBox::warning( this, "Log file is corrupt",
                              "Failed to load this file.\n"
                              "This Log file corrupted or truncated");
-        return;
-    }
-
-    flatbuffers::Verifier verifier( reinterpret_cast<const uint8_t*>(buffer+4),
-                                   size_t(content.size() -4));
+        return false;
 
-    bool valid_tree = Serialization::VerifyBehaviorTreeBuffer(verifier);
-    if( ! valid_tree )
-    {
+    case ReplayLog::Error::INVALID_FORMAT:
         QMessageBox::warning( this, "Flatbuffer verification failed",
                              "Failed to load this file.\n"
                              "Its format is not compatible with the current one");
-        return;
+        return false;
     }
+    return false;
+}
 
+void SidepanelReplay::openLog(const DecodedLog& decoded)
+{
+    if( !checkLogError( decoded.error ) )
+    {
+        return;
+    }
 
-    auto fb_behavior_tree = Serialization::GetBehaviorTree( &buffer[4] );
-
-
-    auto res_pair = BuildTreeFromFlatbuffers( fb_behavior_tree );
-
-    _loaded_tree  = res_pair.first;
-    const auto& uid_to_index = res_pair.second;
+    _loaded_tree  = decoded.tree;
+    _log_file_name = decoded.file_name;
 
     for (const auto& tree_node: _loaded_tree.nodes() )
     {
@@ -233,46 +323,17 @@ void SidepanelReplay::loadLog(const QByteArray &content)
 
     emit loadBehaviorTree( _loaded_tree, "BehaviorTree" );
 
-    _transitions.clear();
-    _transitions.reserve( (content.size() - 4 - bt_header_size) / 12 );
-
-    int idle_counter = _loaded_tree.nodes().size();
-    const int total_nodes = _loaded_tree.nodes().size();
-    int nearest_restart_transition_index = 0;
-
-    for (size_t offset = 4+bt_header_size; offset < content.size(); offset += 12)
-    {
-        Transition transition;
-        const double t_sec  = flatbuffers::ReadScalar<uint32_t>( &buffer[offset] );
-        const double t_usec = flatbuffers::ReadScalar<uint32_t>( &buffer[offset+4] );
-        double timestamp = t_sec + t_usec* 0.000001;
-        transition.timestamp = timestamp;
-        const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset+8]);
-        transition.index = uid_to_index.at(uid);
-        transition.prev_status = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[offset+10] ));
-        transition.status      = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[offset+11] ));
-        transition.is_tree_restart = false;
-
-        if(transition.index == 1 &&
-                (transition.status == NodeStatus::RUNNING || transition.status == NodeStatus::IDLE) &&
-                idle_counter >= total_nodes - 1){
-            transition.is_tree_restart = true;
-            nearest_restart_transition_index = _transitions.size();
-        }
-
-        if(transition.prev_status != NodeStatus::IDLE && transition.status == NodeStatus::IDLE)
-            idle_counter++;
-        else if(transition.prev_status == NodeStatus::IDLE && transition.status != NodeStatus::IDLE)
-            idle_counter--;
+    _log = decoded.log;
+    _statistics = decoded.statistics;
+    _displayed_state.clear();
 
-        transition.nearest_restart_transition_index = nearest_restart_transition_index;
-
-        _transitions.push_back(transition);
-    }
+    _statistics_model->setStatistics( *_statistics, _loaded_tree );
+    _statistics_shown_count = _statistics->processedCount();
 
-    _timepoint.clear();
     _prev_row = -1;
     updateTableModel(_loaded_tree);
+    ui->checkBoxFollow->setEnabled( _log->isMappedFile() );
+    ui->pushButtonCompare->setEnabled( true );
 
 
     // We need to lock the nodes after they are loaded
@@ -287,10 +348,14 @@ void SidepanelReplay::on_spinBox_valueChanged(int value)
     {
         ui->timeSlider->setValue( value );
     }
+    if( !_log || _log->timepoints().empty() )
+    {
+        return;
+    }
 
-    int row = _timepoint[value].second;
+    int row = _log->timepoints()[value].second;
 
-    ui->tableView->scrollTo( _table_model->index(row,0), QAbstractItemView::PositionAtCenter  );
+    scrollToRow( row, QAbstractItemView::PositionAtCenter );
 
     onRowChanged( row );
 }
@@ -301,9 +366,13 @@ void SidepanelReplay::on_timeSlider_valueChanged(int value)
     {
         ui->spinBox->setValue( value );
     }
+    if( !_log || _log->timepoints().empty() )
+    {
+        return;
+    }
 
-    int row = _timepoint[value].second;
-    ui->tableView->scrollTo( _table_model->index(row,0), QAbstractItemView::PositionAtCenter);
+    int row = _log->timepoints()[value].second;
+    scrollToRow( row, QAbstractItemView::PositionAtCenter );
 
     onRowChanged( row );
 }
@@ -324,19 +393,8 @@ void SidepanelReplay::onRowChanged(int current_row)
     ui->tableView->horizontalHeader()->setSectionResizeMode (QHeaderView::Fixed);
     ui->tableView->verticalHeader()->setSectionResizeMode (QHeaderView::Fixed);
 
-    const auto selected_color   = QColor::fromRgb(210, 210, 210);
-    const auto unselected_color = QColor::fromRgb(255, 255, 255);
-
-    for (int row = std::max(0,_prev_row); row <= current_row; row++)
-    {
-        _table_model->item(row, 0)->setBackground( selected_color );
-        _table_model->item(row, 1)->setBackground( selected_color );
-    }
-    for (int row = current_row+1; row <= _prev_row; row++)
-    {
-        _table_model->item(row, 0)->setBackground( unselected_color );
-        _table_model->item(row, 1)->setBackground( unselected_color );
-    }
+    _table_model->setCurrentRow( current_row );
+    _timeline->setCurrentRow( current_row );
 
     // cancel the refresh of the layout refresh
     if( !_layout_update_timer->isActive() )
@@ -347,26 +405,52 @@ void SidepanelReplay::onRowChanged(int current_row)
 
     const QString bt_name("BehaviorTree");
 
-    std::vector<std::pair<int, NodeStatus>>  node_status;
-    for(size_t index = 0; index < _loaded_tree.nodes().size(); index++ )
+    auto state = _displayed_state;
+    if( state.empty() || _prev_row < 0 )
     {
-        node_status.push_back( { index, NodeStatus::IDLE} );
+        state = _log->stateAt( current_row );
+    }
+    else{
+        _log->updateState( _prev_row, current_row, state );
     }
 
-    for (int t = _transitions[current_row].nearest_restart_transition_index; t <= current_row; t++)
+    // MainWindow::onChangeNodesStatus restyles the whole tree when the first node
+    // starts RUNNING. In that case the state of every node must be sent again.
+    const bool full_refresh = ( state.size() < 2 ||
+                                _displayed_state.size() != state.size() ||
+                                !sameState( _displayed_state[1], state[1] ) );
+
+    std::vector<std::pair<int, NodeStatus>>  node_status;
+
+    for(size_t index = 0; index < state.size(); index++ )
     {
-        auto& trans = _transitions[t];
-        node_status.push_back( { trans.index, trans.status} );
+        if( !full_refresh && sameState( _displayed_state[index], state[index] ) )
+        {
+            continue;
+        }
+        // MainWindow::onChangeNodesStatus takes the previous status
+        // from the previous entry with the same index
+        if( state[index].status == NodeStatus::IDLE &&
+            state[index].prev_status != NodeStatus::IDLE )
+        {
+            node_status.push_back( { index, state[index].prev_status } );
+        }
+        node_status.push_back( { index, state[index].status } );
     }
 
-    emit changeNodeStyle( bt_name, node_status );
+    if( !node_status.empty() )
+    {
+        emit changeNodeStyle( bt_name, node_status );
+    }
 
+    _displayed_state = std::move(state);
     _prev_row = current_row;
 }
 
 void SidepanelReplay::updatedSpinAndSlider(int row)
 {
-    auto it = std::upper_bound( _timepoint.begin(), _timepoint.end(), row,
+    const auto& timepoints = _log->timepoints();
+    auto it = std::upper_bound( timepoints.begin(), timepoints.end(), row,
                                 []( int val, const std::pair<double,int>& a ) -> bool
     {
         return val < a.second;
@@ -375,12 +459,15 @@ void SidepanelReplay::updatedSpinAndSlider(int row)
     QSignalBlocker block_spin( ui->spinBox );
     QSignalBlocker block_Slider( ui->timeSlider );
 
-    int index = (it - _timepoint.begin()) -1;
-    index = std::min( index, static_cast<int>(_timepoint.size()) -1 );
+    int index = (it - timepoints.begin()) -1;
+    index = std::min( index, static_cast<int>(timepoints.size()) -1 );
     index = std::max( index, 0 );
 
     ui->spinBox->setValue(index);
     ui->timeSlider->setValue(index);
+
+    QSignalBlocker block_tick( ui->spinBoxTick );
+    ui->spinBoxTick->setValue( static_cast<int>( _log->tickAt(row) ) );
 }
 
 
@@ -392,6 +479,20 @@ bool SidepanelReplay::eventFilter(QObject *object, QEvent *event)
         {
             QKeyEvent *key_event = static_cast<QKeyEvent *>(event);
 
+            if( key_event->key() == Qt::Key_PageDown || key_event->key() == Qt::Key_PageUp )
+            {
+                if( ui->pushButtonNextTick->isEnabled() )
+                {
+                    if( key_event->key() == Qt::Key_PageDown ){
+                        on_pushButtonNextTick_clicked();
+                    }
+                    else{
+                        on_pushButtonPrevTick_clicked();
+                    }
+                }
+                return true;
+            }
+
             int next_row = -1;
             if( key_event->key() ==  Qt::Key_Down)
             {
@@ -406,8 +507,7 @@ bool SidepanelReplay::eventFilter(QObject *object, QEvent *event)
             {
                 onRowChanged( next_row);
                 updatedSpinAndSlider( next_row );
-                ui->tableView->scrollTo( _table_model->index(next_row,0),
-                                         QAbstractItemView::EnsureVisible);
+                scrollToRow( next_row, QAbstractItemView::EnsureVisible );
             }
             return true;
         }
@@ -420,8 +520,9 @@ void SidepanelReplay::on_tableView_clicked(const QModelIndex &index)
     // disable during play
     if( !ui->pushButtonPlay->isChecked())
     {
-        onRowChanged( index.row() );
-        updatedSpinAndSlider( index.row() );
+        const int row = _filter_model->mapToSource(index).row();
+        onRowChanged( row );
+        updatedSpinAndSlider( row );
     }
 }
 
@@ -437,71 +538,263 @@ void SidepanelReplay::on_pushButtonPlay_toggled(bool checked)
 {
     ui->timeSlider->setEnabled( !checked );
     ui->spinBox->setEnabled( !checked );
+    ui->spinBoxTick->setEnabled( !checked );
+    ui->pushButtonPrevTick->setEnabled( !checked );
+    ui->pushButtonNextTick->setEnabled( !checked );
+    ui->toolButtonSlowest->setEnabled( !checked );
 
     if(checked)
     {
-        _next_row = std::max(0, _prev_row);
-        onPlayUpdate();
+        if( transitionsCount() == 0 )
+        {
+            return;
+        }
+        // start again from the beginning, if the end was reached
+        int start_row = std::max(0, _prev_row);
+        if( start_row >= static_cast<int>( transitionsCount() ) - 1 )
+        {
+            start_row = 0;
+        }
+        _play_time = _log->timestamp( start_row );
+        _play_clock.start();
+        _play_timer->start( PLAY_FRAME_PERIOD );
     }
     else{
-        ui->tableView->scrollTo( _table_model->index( _prev_row,0),
-                                 QAbstractItemView::PositionAtCenter);
+        _play_timer->stop();
+        scrollToRow( _prev_row, QAbstractItemView::PositionAtCenter );
     }
 }
 
 void SidepanelReplay::onPlayUpdate()
 {
-    if( !ui->pushButtonPlay->isChecked() || _transitions.empty() )
+    if( !ui->pushButtonPlay->isChecked() || transitionsCount() == 0 )
     {
+        _play_timer->stop();
         return;
-    }  
+    }
 
-    using namespace std::chrono;
-    const int LAST_ROW = _transitions.size()-1;
+    const int LAST_ROW = transitionsCount()-1;
 
-    _next_row = std::max(0, _next_row);
-    _next_row = std::min(LAST_ROW, _next_row);
+    // the log time moves forward by the real time elapsed since the previous frame
+    _play_time += _play_clock.restart() * 0.001 * _play_speed;
 
-    const double TIME_DIFFERENCE_THRESHOLD = 0.01;
+    // last row with timestamp <= _play_time. All the transitions that happened
+    // since the previous frame are sent as a single change of the node styles
+    const size_t end_row = _log->lowerBoundRow( std::nextafter( _play_time,
+                                                                std::numeric_limits<double>::max() ) );
+    const int row = std::max( 0, static_cast<int>(end_row) - 1 );
 
-    // move forward as long as timestamp difference is small.
-    while( _next_row < LAST_ROW -1 &&
-           (_transitions[_next_row+1].timestamp - _transitions[_next_row].timestamp) < TIME_DIFFERENCE_THRESHOLD )
+    if( row != _prev_row )
     {
-        _next_row++;
+        onRowChanged( row );
+        updatedSpinAndSlider( row );
+        scrollToRow( row, QAbstractItemView::EnsureVisible );
     }
 
-    onRowChanged( _next_row );
-    updatedSpinAndSlider( _next_row );
-    ui->tableView->scrollTo( _table_model->index(_next_row,0), QAbstractItemView::EnsureVisible  );
-
-    if( _next_row == LAST_ROW)
+    if( row >= LAST_ROW )
     {
         ui->pushButtonPlay->setChecked(false);
-        return;
     }
+}
 
-    const double prev_time = _transitions[_next_row].timestamp;
-    const double next_time = _transitions[_next_row+1].timestamp;
-    int delay_relative = (next_time - prev_time) * 1000;
+void SidepanelReplay::on_comboBoxSpeed_currentIndexChanged(int index)
+{
+    // items are in the form "0.5x"
+    QString text = ui->comboBoxSpeed->itemText(index);
+    bool ok = false;
+    const double speed = text.remove('x').toDouble(&ok);
+    if( ok && speed > 0 )
+    {
+        _play_speed = speed;
+    }
+}
 
-    _next_row++;
-    //qDebug() << "delay_relative " << delay_relative << " next_row " << _next_row << "\n";
+void SidepanelReplay::on_lineEditFilter_textChanged(const QString &filter_text)
+{
+    _filter_model->setFilter( ReplayFilterModel::parseFilter(filter_text) );
 
-    _play_timer->start(delay_relative);
+    if( _prev_row >= 0 )
+    {
+        scrollToRow( _prev_row, QAbstractItemView::PositionAtCenter );
+    }
 }
 
-void SidepanelReplay::on_lineEditFilter_textChanged(const QString &filter_text)
+void SidepanelReplay::scrollToRow(int row, QAbstractItemView::ScrollHint hint)
 {
-    for (int row=0; row < _table_model->rowCount(); row++ )
+    // the row might be hidden by the filter
+    const QModelIndex index = _filter_model->mapFromSource( _table_model->index(row, 0) );
+    if( index.isValid() )
     {
-        bool show = _table_model->item(row,1)->text().contains(filter_text, Qt::CaseInsensitive);
+        ui->tableView->scrollTo( index, hint );
+    }
+}
 
-        if( show ){
-            ui->tableView->showRow(row);
+void SidepanelReplay::onTimelineClicked(int row)
+{
+    // disable during play
+    if( !ui->pushButtonPlay->isChecked())
+    {
+        seekRow( row );
+    }
+}
+
+void SidepanelReplay::seekRow(int row)
+{
+    onRowChanged( row );
+    updatedSpinAndSlider( row );
+    scrollToRow( row, QAbstractItemView::PositionAtCenter );
+}
+
+void SidepanelReplay::seekTick(size_t tick)
+{
+    if( _log && tick < _log->ticksCount() )
+    {
+        seekRow( static_cast<int>( _log->tickStart(tick) ) );
+    }
+}
+
+void SidepanelReplay::on_pushButtonPrevTick_clicked()
+{
+    if( _log && _prev_row >= 0 )
+    {
+        const size_t tick = _log->tickAt( _prev_row );
+        seekTick( tick > 0 ? tick - 1 : 0 );
+    }
+}
+
+void SidepanelReplay::on_pushButtonNextTick_clicked()
+{
+    if( _log )
+    {
+        seekTick( _prev_row < 0 ? 0 : _log->tickAt( _prev_row ) + 1 );
+    }
+}
+
+void SidepanelReplay::on_spinBoxTick_valueChanged(int tick)
+{
+    seekTick( static_cast<size_t>( std::max(0, tick) ) );
+}
+
+void SidepanelReplay::onSlowestTicksMenu()
+{
+    const size_t SLOWEST_TICKS_COUNT = 10;
+
+    QMenu* menu = ui->toolButtonSlowest->menu();
+    menu->clear();
+    if( !_log )
+    {
+        return;
+    }
+    for (size_t tick: _log->slowestTicks( SLOWEST_TICKS_COUNT ))
+    {
+        const QString text = QString("Tick %1: %2 ms").arg( tick )
+                                 .arg( _log->tickDuration(tick) * 1000.0, 0, 'f', 1 );
+        menu->addAction( text, this, [this, tick]()
+        {
+            seekTick( tick );
+        });
+    }
+}
+
+void SidepanelReplay::on_pushButtonCompare_clicked()
+{
+    if( !_log )
+    {
+        return;
+    }
+    QSettings settings;
+    QString directory_path  = settings.value("SidepanelReplay.lastLoadDirectory",
+                                             QDir::homePath() ).toString();
+
+    QString fileName = QFileDialog::getOpenFileName(this,
+                                                    tr("Compare with"), directory_path,
+                                                    tr("Flatbuffers log (*.fbl *.fblz)"));
+
+    if (fileName.isEmpty() || !QFileInfo::exists(fileName))
+    {
+        return;
+    }
+
+    // the log is read by the worker thread: it must not grow in the meantime
+    ui->checkBoxFollow->setChecked(false);
+
+    std::shared_ptr<const ReplayLog> log_a = _log;
+    const AbsBehaviorTree tree_a = _loaded_tree;
+    const QString name_a = _log_file_name.isEmpty() ? tr("Current log")
+                                                    : QFileInfo(_log_file_name).fileName();
+
+    decodeLogFile( fileName, log_a, [this, log_a, tree_a, name_a](const DecodedLog& decoded)
+    {
+        if( !checkLogError( decoded.error ) )
+        {
+            return;
         }
-        else{
-            ui->tableView->hideRow(row);
+        auto dialog = new ReplayCompareDialog( log_a, tree_a, name_a,
+                                               decoded.log, decoded.tree,
+                                               QFileInfo(decoded.file_name).fileName(),
+                                               decoded.diff, this );
+        dialog->setAttribute( Qt::WA_DeleteOnClose );
+        dialog->show();
+    });
+}
+
+void SidepanelReplay::on_checkBoxFollow_toggled(bool checked)
+{
+    if( checked )
+    {
+        _follow_timer->start(250);
+    }
+    else{
+        _follow_timer->stop();
+    }
+}
+
+void SidepanelReplay::onFollowUpdate()
+{
+    if( !_log || !_log->isMappedFile() )
+    {
+        return;
+    }
+    const int prev_last_row = static_cast<int>( transitionsCount() ) - 1;
+
+    if( _log->update() == 0 )
+    {
+        if( _log->error() != ReplayLog::Error::NONE )
+        {
+            ui->checkBoxFollow->setChecked(false);
         }
+        return;
+    }
+
+    _table_model->transitionsAppended();
+    _timeline->transitionsAppended();
+    _statistics->process( *_log );
+    updateStatisticsModel();
+    updateTimeRange();
+
+    // like "tail -f": if the last row was selected, keep showing the end of the log
+    if( _prev_row == prev_last_row && !ui->pushButtonPlay->isChecked() )
+    {
+        const int last_row = static_cast<int>( transitionsCount() ) - 1;
+        onRowChanged( last_row );
+        updatedSpinAndSlider( last_row );
+        scrollToRow( last_row, QAbstractItemView::EnsureVisible );
+    }
+}
+
+void SidepanelReplay::on_tabWidget_currentChanged(int)
+{
+    updateStatisticsModel();
+}
+
+void SidepanelReplay::updateStatisticsModel()
+{
+    // computing the percentiles is not free: do it only if they are visible
+    if( !_statistics || ui->tabWidget->currentWidget() != ui->tabStatistics ||
+        _statistics_shown_count == _statistics->processedCount() )
+    {
+        return;
     }
+    _statistics_model->setStatistics( *_statistics, _loaded_tree );
+    _statistics_shown_count = _statistics->processedCount();
 }
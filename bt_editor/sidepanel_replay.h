@@ -2,10 +2,19 @@
 #define SIDEPANEL_REPLAY_H
 
 #include <chrono>
+#include <functional>
+#include <memory>
 #include <QFrame>
-#include <QTableWidgetItem>
-#include <QStandardItemModel>
+#include <QAbstractItemView>
+#include <QElapsedTimer>
 #include "bt_editor_base.h"
+#include "replay_log.h"
+#include "replay_table_model.h"
+#include "replay_filter_model.h"
+#include "replay_statistics.h"
+#include "replay_statistics_model.h"
+#include "replay_timeline_widget.h"
+#include "replay_diff.h"
 
 
 namespace Ui {
@@ -24,7 +33,9 @@ public:
 
     void loadLog(const QByteArray& content);
 
-    size_t transitionsCount() const { return _transitions.size(); }
+    void loadLogFile(const QString& file_name);
+
+    size_t transitionsCount() const { return _log ? _log->transitionsCount() : 0; }
 
 public slots:
 
@@ -44,8 +55,28 @@ private slots:
 
     void onPlayUpdate();
 
+    void on_comboBoxSpeed_currentIndexChanged(int index);
+
     void on_lineEditFilter_textChanged(const QString &filter_text);
 
+    void on_checkBoxFollow_toggled(bool checked);
+
+    void on_pushButtonCompare_clicked();
+
+    void onFollowUpdate();
+
+    void onTimelineClicked(int row);
+
+    void on_pushButtonPrevTick_clicked();
+
+    void on_pushButtonNextTick_clicked();
+
+    void on_spinBoxTick_valueChanged(int tick);
+
+    void onSlowestTicksMenu();
+
+    void on_tabWidget_currentChanged(int index);
+
 signals:
     void loadBehaviorTree(const AbsBehaviorTree& tree, const QString& name );
 
@@ -60,34 +91,85 @@ private:
 
     void loadFromFlatbuffers(const std::vector<int8_t>& serialized_description);
 
+    // result of the decoding, done in a worker thread by decodeLogFile()
+    struct DecodedLog{
+        QString file_name;
+        std::shared_ptr<ReplayLog> log;
+        std::shared_ptr<ReplayStatistics> statistics;
+        ReplayLog::Error error;
+        AbsBehaviorTree tree;
+        // only if the log was compared with another one
+        ReplayDiff diff;
+    };
+
+    // Decode a file in a worker thread, showing a progress dialog.
+    // If compare_with is not null, the worker compares the two logs too.
+    // on_decoded is called by the GUI thread.
+    void decodeLogFile(const QString& file_name,
+                       std::shared_ptr<const ReplayLog> compare_with,
+                       std::function<void(const DecodedLog&)> on_decoded);
+
+    // show a message and return false, if there is an error
+    bool checkLogError(ReplayLog::Error error);
+
+    static DecodedLog decodeLog(std::shared_ptr<ReplayLog> log,
+                                const ReplayLog::ProgressCallback& progress);
+
+    void openLog(const DecodedLog& decoded);
+
     void onRowChanged(int value);
 
     Ui::SidepanelReplay *ui;
 
-    struct Transition{
-        int16_t index;
-        double timestamp;
-        NodeStatus prev_status;
-        NodeStatus status;
-        bool is_tree_restart;
-        int nearest_restart_transition_index;
-    };
-    std::vector<Transition> _transitions;
-    std::vector< std::pair<double,int>> _timepoint;
+    // modified only by the GUI thread, when following a file that grows
+    std::shared_ptr<ReplayLog> _log;
+
+    std::shared_ptr<ReplayStatistics> _statistics;
+
+    // state of the nodes as it was sent with the last changeNodeStyle
+    std::vector<ReplayLog::NodeState> _displayed_state;
 
     int _prev_row;
-    int _next_row;
+
+    // playback position, in the time of the log
+    double _play_time;
+    double _play_speed;
+    QElapsedTimer _play_clock;
 
     void updatedSpinAndSlider(int row);
 
-    QStandardItemModel* _table_model;
+    void updateTimeRange();
+
+    // select the row, move the slider and the table to it
+    void seekRow(int row);
+
+    void seekTick(size_t tick);
+
+    void scrollToRow(int row, QAbstractItemView::ScrollHint hint);
+
+    ReplayTableModel* _table_model;
+
+    ReplayFilterModel* _filter_model;
+
+    ReplayStatisticsModel* _statistics_model;
+
+    ReplayTimelineWidget* _timeline;
+
+    // transitions included in _statistics_model
+    size_t _statistics_shown_count;
+
+    void updateStatisticsModel();
 
     QTimer *_layout_update_timer;
 
     QTimer *_play_timer;
 
+    QTimer *_follow_timer;
+
     AbsBehaviorTree _loaded_tree;
 
+    QString _log_file_name;
+
     void updateTableModel(const AbsBehaviorTree &tree);
 
     QWidget *_parent;
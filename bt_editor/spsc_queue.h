@@ -0,0 +1,88 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * Lock-free, bounded queue with a single producer thread and a single
+ * consumer thread. The capacity is rounded up to a power of two.
+ *
+ * push() never blocks: when the queue is full it fails and the producer
+ * decides what to drop.
+ */
+template <typename T>
+class SPSCQueue
+{
+public:
+    explicit SPSCQueue(size_t capacity):
+        _head(0),
+        _tail(0)
+    {
+        size_t size = 1;
+        while( size < capacity )
+        {
+            size *= 2;
+        }
+        _buffer.resize( size );
+        _mask = size - 1;
+    }
+
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    // producer only
+    bool push(T&& value)
+    {
+        const size_t tail = _tail.load( std::memory_order_relaxed );
+        if( tail - _head.load( std::memory_order_acquire ) == _buffer.size() )
+        {
+            return false;
+        }
+        _buffer[ tail & _mask ] = std::move(value);
+        _tail.store( tail + 1, std::memory_order_release );
+        return true;
+    }
+
+    // consumer only
+    bool pop(T& value)
+    {
+        const size_t head = _head.load( std::memory_order_relaxed );
+        if( head == _tail.load( std::memory_order_acquire ) )
+        {
+            return false;
+        }
+        value = std::move( _buffer[ head & _mask ] );
+        _head.store( head + 1, std::memory_order_release );
+        return true;
+    }
+
+    // approximate, if the other thread is running
+    size_t size() const
+    {
+        // head first: it can't overtake a tail loaded later
+        const size_t head = _head.load( std::memory_order_acquire );
+        return _tail.load( std::memory_order_acquire ) - head;
+    }
+
+    size_t capacity() const { return _buffer.size(); }
+
+private:
+    std::vector<T> _buffer;
+    size_t _mask;
+
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    // On different cache lines: each one is written by a single thread.
+    // Padding rather than alignas(), that C++11 doesn't honour for objects
+    // allocated with new. The members after _tail don't share its line.
+    char _pad_before[CACHE_LINE_SIZE];
+    std::atomic<size_t> _head;
+    char _pad_head[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> _tail;
+    char _pad_tail[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+};
+
+#endif // SPSC_QUEUE_H
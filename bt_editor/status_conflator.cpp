@@ -0,0 +1,91 @@
+#include "status_conflator.h"
+
+StatusConflator::StatusConflator():
+    _restarted(false),
+    _added_count(0),
+    _conflated_count(0)
+{
+}
+
+void StatusConflator::reset(size_t nodes_count)
+{
+    _nodes.assign( nodes_count, { NodeStatus::IDLE, NodeStatus::IDLE, false, false } );
+    _dirty.clear();
+    _restarted = false;
+    _added_count = 0;
+    _conflated_count = 0;
+}
+
+void StatusConflator::add(int index, NodeStatus status)
+{
+    if( index < 0 || static_cast<size_t>(index) >= _nodes.size() )
+    {
+        return;
+    }
+    _added_count++;
+
+    // the style of the nodes changed so far will be reset anyway
+    if( index == 1 && status == NodeStatus::RUNNING )
+    {
+        for (int dirty_index: _dirty)
+        {
+            _nodes[dirty_index].dirty = false;
+            _nodes[dirty_index].has_previous = false;
+        }
+        _dirty.clear();
+        _restarted = true;
+    }
+
+    NodeEntry& node = _nodes[index];
+    if( node.dirty )
+    {
+        node.previous = node.latest;
+        node.has_previous = true;
+    }
+    else{
+        node.dirty = true;
+        _dirty.push_back( index );
+    }
+    node.latest = status;
+}
+
+void StatusConflator::take(std::vector<std::pair<int, NodeStatus>> &node_status)
+{
+    node_status.clear();
+    size_t emitted = 0;
+
+    if( _restarted )
+    {
+        node_status.push_back( { 1, NodeStatus::RUNNING } );
+        emitted++;
+    }
+
+    for (int index: _dirty)
+    {
+        NodeEntry& node = _nodes[index];
+
+        // the restart itself was added already
+        const bool is_restart = ( _restarted && index == 1 && !node.has_previous );
+        if( !is_restart )
+        {
+            // the style of IDLE depends on the status before it
+            if( node.latest == NodeStatus::IDLE && node.has_previous &&
+                node.previous != NodeStatus::IDLE )
+            {
+                node_status.push_back( { index, node.previous } );
+            }
+            node_status.push_back( { index, node.latest } );
+            emitted++;
+        }
+        node.dirty = false;
+        node.has_previous = false;
+    }
+
+    if( _added_count > emitted )
+    {
+        _conflated_count += _added_count - emitted;
+    }
+    _dirty.clear();
+    _restarted = false;
+    _added_count = 0;
+}
@@ -0,0 +1,58 @@
+#ifndef STATUS_CONFLATOR_H
+#define STATUS_CONFLATOR_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <behaviortree_cpp_v3/basic_types.h>
+
+using BT::NodeStatus;
+
+/**
+ * Merges the transitions received during a frame, keeping only what changes
+ * the way the tree is drawn by MainWindow::onChangeNodesStatus():
+ *
+ * - the last status of each node and, if it is IDLE, the status before it;
+ * - the last restart of the tree (the first node becoming RUNNING), that resets
+ *   the style of all the nodes changed before it.
+ *
+ * The work is proportional to the number of transitions, not of nodes.
+ */
+class StatusConflator
+{
+public:
+
+    StatusConflator();
+
+    void reset(size_t nodes_count);
+
+    void add(int index, NodeStatus status);
+
+    bool empty() const { return _dirty.empty() && !_restarted; }
+
+    // The merged transitions, to be passed to onChangeNodesStatus(),
+    // and start a new frame.
+    void take(std::vector<std::pair<int, NodeStatus>>& node_status);
+
+    // transitions merged into a later one, since reset()
+    size_t conflatedCount() const { return _conflated_count; }
+
+private:
+
+    struct NodeEntry{
+        NodeStatus latest;
+        NodeStatus previous;
+        bool has_previous;
+        bool dirty;
+    };
+
+    std::vector<NodeEntry> _nodes;
+    // nodes changed in this frame, in order of first change
+    std::vector<int> _dirty;
+    bool _restarted;
+    size_t _added_count;
+    size_t _conflated_count;
+};
+
+#endif // STATUS_CONFLATOR_H
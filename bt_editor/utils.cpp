@@ -540,6 +540,38 @@ getStyleFromStatus(NodeStatus status, NodeStatus prev_status)
     return {node_style, conn_style};
 }
 
+const StatusStyle& getSharedStyleFromStatus(NodeStatus status, NodeStatus prev_status)
+{
+    // IDLE, RUNNING, SUCCESS and FAILURE
+    const int STATUS_COUNT = 4;
+
+    // built on first use, when the application already started
+    static const std::vector<StatusStyle> table = []()
+    {
+        std::vector<StatusStyle> styles;
+        styles.reserve( STATUS_COUNT * STATUS_COUNT );
+        for (int s = 0; s < STATUS_COUNT; s++)
+        {
+            for (int p = 0; p < STATUS_COUNT; p++)
+            {
+                auto style = getStyleFromStatus( static_cast<NodeStatus>(s),
+                                                 static_cast<NodeStatus>(p) );
+                styles.push_back( { std::make_shared<const QtNodes::NodeStyle>( style.first ),
+                                    std::make_shared<const QtNodes::ConnectionStyle>( style.second ) } );
+            }
+        }
+        return styles;
+    }();
+
+    const int s = static_cast<int>(status);
+    const int p = static_cast<int>(prev_status);
+    if( s < 0 || s >= STATUS_COUNT || p < 0 || p >= STATUS_COUNT )
+    {
+        return table.front();
+    }
+    return table[ s * STATUS_COUNT + p ];
+}
+
 QtNodes::Node *GetParentNode(QtNodes::Node *node)
 {
     using namespace QtNodes;
@@ -2,6 +2,7 @@
 #define NODE_UTILS_H
 
 #include <QDomDocument>
+#include <memory>
 #include <nodes/NodeData>
 #include <nodes/FlowScene>
 #include <nodes/NodeStyle>
@@ -31,6 +32,16 @@ void NodeReorder(QtNodes::FlowScene &scene, AbsBehaviorTree &abstract_tree );
 std::pair<QtNodes::NodeStyle, QtNodes::ConnectionStyle>
 getStyleFromStatus(NodeStatus status, NodeStatus prev_status);
 
+struct StatusStyle
+{
+    std::shared_ptr<const QtNodes::NodeStyle> node;
+    std::shared_ptr<const QtNodes::ConnectionStyle> connection;
+};
+
+// Same styles of getStyleFromStatus(), computed once for the 16 combinations
+// and shared by all the nodes: nothing is allocated or copied per update.
+const StatusStyle& getSharedStyleFromStatus(NodeStatus status, NodeStatus prev_status);
+
 QtNodes::Node* GetParentNode(QtNodes::Node* node);
 
 std::set<QString> GetModelsToRemove(QWidget* parent,
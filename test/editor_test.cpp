@@ -27,6 +27,10 @@ private slots:
     void longNames();
     void clearModels();
     void undoWithSubtreeExpanded();
+    void treeIndexCache();
+
+private:
+    bool treeIndexMatchesScene(GraphicContainer* container);
 };
 
 
@@ -633,6 +637,70 @@ void EditorTest::undoWithSubtreeExpanded()
      sleepAndRefresh( 500 );
 }
 
+bool EditorTest::treeIndexMatchesScene(GraphicContainer *container)
+{
+    // same nodes and input connections of a tree built from scratch
+    const auto tree = BuildTreeFromScene( container->scene() );
+    const auto& tree_index = container->treeIndex();
+    if( tree_index.size() != tree.nodesCount() )
+    {
+        return false;
+    }
+    for (size_t index = 0; index < tree_index.size(); index++)
+    {
+        auto gui_node = tree.nodes()[index].graphic_node;
+        const auto& conn_in = gui_node->nodeState().connections(QtNodes::PortType::In, 0);
+        auto input = conn_in.size() == 1 ? conn_in.begin()->second : nullptr;
+
+        if( tree_index[index].node != gui_node || tree_index[index].input != input )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void EditorTest::treeIndexCache()
+{
+    QString file_xml = readFile(":/crossdoor_with_subtree.xml");
+    main_win->on_actionNew_triggered();
+    main_win->loadFromXML( file_xml );
+
+    auto container = main_win->getTabByName("MainTree");
+    auto scene = container->scene();
+    QVERIFY( treeIndexMatchesScene(container) );
+    const size_t nodes_count = container->treeIndex().size();
+
+    auto abs_tree = getAbstractTree("MainTree");
+    auto fallback_node = abs_tree.findFirstNode("root_Fallback")->graphic_node;
+    auto window_node   = abs_tree.findFirstNode("PassThroughWindow")->graphic_node;
+    auto sequence_node = abs_tree.findFirstNode("door_open_sequence")->graphic_node;
+
+    // node created and connected, after its siblings in both layouts
+    auto& new_node = scene->createNode( scene->registry().create("PassThroughWindow") );
+    scene->setNodePosition( new_node, scene->getNodePosition( *window_node ) + QPointF(200, 200) );
+    scene->createConnection( new_node, 0, *fallback_node, 0 );
+    QCOMPARE( container->treeIndex().size(), nodes_count + 1 );
+    QVERIFY( treeIndexMatchesScene(container) );
+
+    // moved before its siblings, and nodeMoved emitted as at the end of a drag
+    const QPointF first_pos = scene->getNodePosition( *sequence_node ) - QPointF(400, 400);
+    scene->setNodePosition( new_node, first_pos );
+    emit scene->nodeMoved( new_node, first_pos );
+    QVERIFY( treeIndexMatchesScene(container) );
+
+    scene->removeNode( new_node );
+    QCOMPARE( container->treeIndex().size(), nodes_count );
+    QVERIFY( treeIndexMatchesScene(container) );
+
+    // the signals of the scene are blocked while the subtree is deleted
+    container->deleteSubTreeRecursively( *sequence_node );
+    QCOMPARE( container->treeIndex().size(), nodes_count - 3 );
+    QVERIFY( treeIndexMatchesScene(container) );
+
+    sleepAndRefresh( 500 );
+}
+
 QTEST_MAIN(EditorTest)
 
 #include "editor_test.moc"
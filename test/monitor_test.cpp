@@ -0,0 +1,249 @@
+#include "groot_test_base.h"
+#include "bt_editor/status_conflator.h"
+#include "bt_editor/monitor_receiver.h"
+#include "bt_editor/replay_log.h"
+#include "bt_editor/spsc_queue.h"
+#include <thread>
+
+class MonitorTest : public GrootTestBase
+{
+    Q_OBJECT
+
+public:
+    MonitorTest() {}
+    ~MonitorTest() {}
+
+private slots:
+    void conflateStatus();
+    void decodeMessage();
+    void spscQueue();
+
+private:
+    // a message of PublisherZMQ with all the nodes of the tree and the given records
+    QByteArray monitorMessage(const Serialization::BehaviorTree* tree, const QByteArray& records);
+};
+
+
+void MonitorTest::conflateStatus()
+{
+    typedef std::vector<std::pair<int, NodeStatus>> NodeStatusList;
+
+    StatusConflator conflator;
+    conflator.reset(5);
+    QVERIFY( conflator.empty() );
+
+    NodeStatusList node_status;
+    NodeStatusList expected;
+
+    // the last status of each node, in order of first change
+    conflator.add( 3, NodeStatus::RUNNING );
+    conflator.add( 2, NodeStatus::RUNNING );
+    conflator.add( 3, NodeStatus::SUCCESS );
+    QVERIFY( !conflator.empty() );
+    conflator.take( node_status );
+    expected = { {3, NodeStatus::SUCCESS}, {2, NodeStatus::RUNNING} };
+    QVERIFY( node_status == expected );
+    QCOMPARE( conflator.conflatedCount(), size_t(1) );
+
+    // flushed: nothing left for the next frame
+    QVERIFY( conflator.empty() );
+    conflator.take( node_status );
+    QVERIFY( node_status.empty() );
+
+    // IDLE is drawn according to the status before it
+    conflator.add( 4, NodeStatus::RUNNING );
+    conflator.add( 4, NodeStatus::FAILURE );
+    conflator.add( 4, NodeStatus::IDLE );
+    conflator.take( node_status );
+    expected = { {4, NodeStatus::FAILURE}, {4, NodeStatus::IDLE} };
+    QVERIFY( node_status == expected );
+    QCOMPARE( conflator.conflatedCount(), size_t(3) );
+
+    // the restart resets the style of the nodes changed before it
+    conflator.add( 2, NodeStatus::SUCCESS );
+    conflator.add( 1, NodeStatus::RUNNING );
+    conflator.add( 3, NodeStatus::RUNNING );
+    conflator.add( 1, NodeStatus::SUCCESS );
+    conflator.take( node_status );
+    expected = { {1, NodeStatus::RUNNING}, {1, NodeStatus::SUCCESS}, {3, NodeStatus::RUNNING} };
+    QVERIFY( node_status == expected );
+    QCOMPARE( conflator.conflatedCount(), size_t(4) );
+
+    // indices outside of the tree are ignored
+    conflator.add( -1, NodeStatus::RUNNING );
+    conflator.add( 5, NodeStatus::RUNNING );
+    QVERIFY( conflator.empty() );
+
+    conflator.reset(5);
+    QCOMPARE( conflator.conflatedCount(), size_t(0) );
+}
+
+QByteArray MonitorTest::monitorMessage(const Serialization::BehaviorTree *tree,
+                                       const QByteArray &records)
+{
+    const int header_size = 3 * static_cast<int>( tree->nodes()->size() );
+    QByteArray message( 8 + header_size, '\0' );
+    char* data = message.data();
+
+    flatbuffers::WriteScalar<uint32_t>( data, static_cast<uint32_t>(header_size) );
+    int offset = 4;
+    for (const auto& node: *tree->nodes())
+    {
+        flatbuffers::WriteScalar<uint16_t>( &data[offset], node->uid() );
+        flatbuffers::WriteScalar<int8_t>( &data[offset+2],
+                                          static_cast<int8_t>(Serialization::NodeStatus::RUNNING) );
+        offset += 3;
+    }
+    flatbuffers::WriteScalar<uint32_t>( &data[offset],
+                                        static_cast<uint32_t>( records.size() ) / REPLAY_RECORD_SIZE );
+    return message + records;
+}
+
+void MonitorTest::decodeMessage()
+{
+    QByteArray content = readFile("://crossdoor_trace.fbl");
+
+    ReplayLog log;
+    QVERIFY( log.openBuffer( content ) );
+    QVERIFY( log.buildIndex() );
+    QVERIFY( log.transitionsCount() >= 3 );
+
+    size_t transitions_offset = 0;
+    std::vector<int16_t> uid_to_index;
+    QVERIFY( ParseReplayHeader( content.constData(), static_cast<size_t>( content.size() ),
+                                transitions_offset, uid_to_index ) == ReplayFormatError::NONE );
+
+    const QByteArray records = content.mid( static_cast<int>(transitions_offset),
+                                            static_cast<int>(3 * REPLAY_RECORD_SIZE) );
+    const QByteArray valid = monitorMessage( log.behaviorTree(), records );
+
+    auto decode = [&](const QByteArray& buffer, MonitorMessage& message)
+    {
+        return DecodeMonitorMessage( buffer.constData(), static_cast<size_t>( buffer.size() ),
+                                     uid_to_index, log.nodesCount(), message );
+    };
+
+    MonitorMessage message;
+    QVERIFY( decode( valid, message ) == MonitorMessage::Result::OK );
+    QCOMPARE( message.tree_status.size(), log.nodesCount() );
+    QVERIFY( message.tree_status[0] == NodeStatus::IDLE );
+    QVERIFY( message.tree_status[1] == NodeStatus::RUNNING );
+    QCOMPARE( message.node_status.size(), size_t(3) );
+    for (size_t row = 0; row < 3; row++)
+    {
+        QCOMPARE( message.node_status[row].first, static_cast<int>( log.nodeIndex(row) ) );
+        QVERIFY( message.node_status[row].second == log.status(row) );
+    }
+    QCOMPARE( message.timestamp, log.timestamp(2) );
+    QVERIFY( message.records == records );
+
+    // truncated anywhere
+    for (int size = 0; size < valid.size(); size++)
+    {
+        QVERIFY( decode( valid.left(size), message ) == MonitorMessage::Result::MALFORMED );
+        QVERIFY( message.node_status.empty() );
+    }
+
+    // size of the header past the end of the message, or not a multiple of 3
+    const int header_size = valid.size() - 8 - records.size();
+    for (uint32_t wrong_size: { uint32_t(valid.size()), uint32_t(0xFFFFFFFF),
+                                uint32_t(header_size + 1), uint32_t(header_size + records.size() + 3) })
+    {
+        QByteArray wrong = valid;
+        flatbuffers::WriteScalar<uint32_t>( wrong.data(), wrong_size );
+        QVERIFY( decode( wrong, message ) == MonitorMessage::Result::MALFORMED );
+    }
+
+    // more transitions than the ones in the message
+    {
+        QByteArray wrong = valid;
+        flatbuffers::WriteScalar<uint32_t>( &wrong.data()[4 + header_size], uint32_t(4) );
+        QVERIFY( decode( wrong, message ) == MonitorMessage::Result::MALFORMED );
+        flatbuffers::WriteScalar<uint32_t>( &wrong.data()[4 + header_size], uint32_t(0xFFFFFFFF) );
+        QVERIFY( decode( wrong, message ) == MonitorMessage::Result::MALFORMED );
+    }
+
+    // unknown uid in the header and in a transition: the tree must be reloaded
+    {
+        QByteArray wrong = valid;
+        flatbuffers::WriteScalar<uint16_t>( &wrong.data()[4], uint16_t(0xFFFF) );
+        QVERIFY( decode( wrong, message ) == MonitorMessage::Result::UNKNOWN_UID );
+
+        wrong = valid;
+        flatbuffers::WriteScalar<uint16_t>( &wrong.data()[8 + header_size + REPLAY_RECORD_SIZE + 8],
+                                            uint16_t(uid_to_index.size()) );
+        QVERIFY( decode( wrong, message ) == MonitorMessage::Result::UNKNOWN_UID );
+    }
+}
+
+void MonitorTest::spscQueue()
+{
+    // rounded up to a power of two
+    SPSCQueue<int> queue(5);
+    QCOMPARE( queue.capacity(), size_t(8) );
+
+    int value = 0;
+    QVERIFY( !queue.pop(value) );
+
+    // full: push fails and nothing is overwritten
+    for (int i = 0; i < 8; i++)
+    {
+        QVERIFY( queue.push( int(i) ) );
+    }
+    QVERIFY( !queue.push( 8 ) );
+    QCOMPARE( queue.size(), size_t(8) );
+
+    // the indices wrap around the buffer many times, in FIFO order
+    int next_push = 8;
+    int next_pop = 0;
+    for (int round = 0; round < 100; round++)
+    {
+        const int pops = 1 + round % 8;
+        for (int i = 0; i < pops; i++)
+        {
+            QVERIFY( queue.pop(value) );
+            QCOMPARE( value, next_pop++ );
+        }
+        while( queue.push( int(next_push) ) )
+        {
+            next_push++;
+        }
+        QCOMPARE( queue.size(), size_t(8) );
+    }
+
+    while( queue.pop(value) )
+    {
+        QCOMPARE( value, next_pop++ );
+    }
+    QCOMPARE( next_pop, next_push );
+    QCOMPARE( queue.size(), size_t(0) );
+
+    // one producer and one consumer thread
+    SPSCQueue<int> shared_queue(16);
+    const int COUNT = 100000;
+    std::thread producer( [&shared_queue, COUNT]()
+    {
+        for (int i = 0; i < COUNT; )
+        {
+            if( shared_queue.push( int(i) ) )
+            {
+                i++;
+            }
+        }
+    });
+    bool in_order = true;
+    for (int expected = 0; expected < COUNT; )
+    {
+        if( shared_queue.pop(value) )
+        {
+            in_order = in_order && (value == expected);
+            expected++;
+        }
+    }
+    producer.join();
+    QVERIFY( in_order );
+}
+
+QTEST_MAIN(MonitorTest)
+
+#include "monitor_test.moc"
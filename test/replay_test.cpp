@@ -1,6 +1,17 @@
 #include "groot_test_base.h"
 #include "bt_editor/sidepanel_replay.h"
+#include "bt_editor/replay_log.h"
+#include "bt_editor/replay_table_model.h"
+#include "bt_editor/replay_filter_model.h"
+#include "bt_editor/replay_statistics.h"
+#include "bt_editor/replay_diff.h"
+#include "bt_editor/replay_stream.h"
+#include "bt_editor/replay_archive.h"
+#include "bt_editor/replay_writer.h"
+#include "bt_editor/utils.h"
 #include <QAction>
+#include <QTemporaryFile>
+#include <cmath>
 
 class ReplyTest : public GrootTestBase
 {
@@ -14,11 +25,32 @@ private slots:
     void initTestCase();
     void cleanupTestCase();
     void basicLoad();
+    void checkpointSeek();
+    void filterRows();
+    void followLog();
+    void columnarStore();
+    void statistics();
+    void compareLogs();
+    void tickIndex();
+    void streamDecode();
+    void archive();
+    void writeLog();
+
+private:
+    // open the content and build its index
+    bool openLog(ReplayLog& log, const QByteArray& content);
+
+    // the file is closed, to be opened by name
+    bool writeFile(QTemporaryFile& file, const QByteArray& content);
+
+    QByteArray _crossdoor_trace;
 };
 
 
 void ReplyTest::initTestCase()
 {
+    _crossdoor_trace = readFile("://crossdoor_trace.fbl");
+
     main_win = new MainWindow(GraphicMode::REPLAY, nullptr);
     main_win->resize(1200, 800);
     main_win->show();
@@ -32,6 +64,21 @@ void ReplyTest::cleanupTestCase()
     main_win->close();
 }
 
+bool ReplyTest::openLog(ReplayLog &log, const QByteArray &content)
+{
+    return log.openBuffer( content ) && log.buildIndex();
+}
+
+bool ReplyTest::writeFile(QTemporaryFile &file, const QByteArray &content)
+{
+    if( !file.open() || file.write( content ) != content.size() )
+    {
+        return false;
+    }
+    file.close();
+    return true;
+}
+
 void ReplyTest::basicLoad()
 {
     auto sidepanel_replay = main_win->findChild<SidepanelReplay*>("SidepanelReplay");
@@ -43,6 +90,460 @@ void ReplyTest::basicLoad()
     QCOMPARE( sidepanel_replay->transitionsCount(), size_t(27) );
 }
 
+void ReplyTest::checkpointSeek()
+{
+    ReplayLog log;
+    QVERIFY( log.openBuffer( _crossdoor_trace ) );
+    QVERIFY( log.buildIndex( ReplayLog::ProgressCallback(), 4 ) );
+
+    // replay every transition since the last restart, as done before checkpoints
+    for (size_t row = 0; row < log.transitionsCount(); row++)
+    {
+        std::vector<ReplayLog::NodeState> expected( log.nodesCount(),
+                                                    { NodeStatus::IDLE, NodeStatus::IDLE } );
+        for (size_t t = log.nearestRestart(row); t <= row; t++)
+        {
+            auto& node_state = expected[ log.nodeIndex(t) ];
+            node_state.prev_status = node_state.status;
+            node_state.status = log.status(t);
+        }
+
+        const auto state = log.stateAt(row);
+        QCOMPARE( state.size(), expected.size() );
+
+        // incremental update from the previous row, as done during playback
+        auto updated = log.stateAt( row > 0 ? row-1 : 0 );
+        log.updateState( row > 0 ? row-1 : 0, row, updated );
+        QCOMPARE( updated.size(), expected.size() );
+
+        for (size_t index = 0; index < state.size(); index++)
+        {
+            QVERIFY( state[index].status == expected[index].status );
+            QVERIFY( state[index].prev_status == expected[index].prev_status );
+            QVERIFY( updated[index].status == expected[index].status );
+            QVERIFY( updated[index].prev_status == expected[index].prev_status );
+        }
+    }
+}
+
+void ReplyTest::filterRows()
+{
+    auto log = std::make_shared<ReplayLog>();
+    QVERIFY( openLog( *log, _crossdoor_trace ) );
+    const auto tree = BuildTreeFromFlatbuffers( log->behaviorTree() ).first;
+
+    ReplayTableModel table_model;
+    table_model.setLog( log, tree );
+    ReplayFilterModel filter_model;
+    filter_model.setSourceModel( &table_model );
+    filter_model.setLog( log, tree );
+
+    QCOMPARE( filter_model.rowCount(), table_model.rowCount() );
+
+    const auto filter = ReplayFilterModel::parseFilter("door status:fail type:act");
+    QCOMPARE( filter.name, QString("door") );
+    QCOMPARE( filter.statuses.size(), size_t(1) );
+    QCOMPARE( filter.types.size(), size_t(1) );
+    filter_model.setFilter( filter );
+
+    // same result of a linear scan of the table
+    std::vector<int> expected;
+    for (int row = 0; row < table_model.rowCount(); row++)
+    {
+        const auto& node = tree.nodes()[ log->nodeIndex(row) ];
+        if( node.instance_name.contains("door", Qt::CaseInsensitive) &&
+            node.model.type == NodeType::ACTION &&
+            log->status(row) == NodeStatus::FAILURE )
+        {
+            expected.push_back(row);
+        }
+    }
+    QCOMPARE( filter_model.rowCount(), static_cast<int>(expected.size()) );
+    for (int row = 0; row < filter_model.rowCount(); row++)
+    {
+        QCOMPARE( filter_model.mapToSource( filter_model.index(row, 0) ).row(), expected[row] );
+    }
+
+    filter_model.setFilter( ReplayFilterModel::parseFilter("") );
+    QCOMPARE( filter_model.rowCount(), table_model.rowCount() );
+}
+
+void ReplyTest::followLog()
+{
+    const QByteArray& content = _crossdoor_trace;
+
+    ReplayLog full_log;
+    QVERIFY( openLog( full_log, content ) );
+    const size_t count = full_log.transitionsCount();
+    QVERIFY( count > 3 );
+
+    const int header_size = 4 + static_cast<int>( flatbuffers::ReadScalar<uint32_t>( content.constData() ) );
+    const int record_size = static_cast<int>( ReplayLog::TRANSITION_SIZE );
+    auto records_end = [&](size_t rows) { return header_size + static_cast<int>(rows) * record_size; };
+
+    // the logger wrote all but 3 records
+    QTemporaryFile file;
+    QVERIFY( writeFile( file, content.left( records_end(count - 3) ) ) );
+
+    auto log = std::make_shared<ReplayLog>();
+    QVERIFY( log->openFile( file.fileName() ) );
+    QVERIFY( log->isMappedFile() );
+    QVERIFY( log->buildIndex() );
+    QCOMPARE( log->transitionsCount(), count - 3 );
+
+    const auto tree = BuildTreeFromFlatbuffers( log->behaviorTree() ).first;
+    ReplayTableModel table_model;
+    table_model.setLog( log, tree );
+    ReplayFilterModel filter_model;
+    filter_model.setSourceModel( &table_model );
+    filter_model.setLog( log, tree );
+    ReplayFilterModel unfiltered_model;
+    unfiltered_model.setSourceModel( &table_model );
+    unfiltered_model.setLog( log, tree );
+
+    // the node of the last transition, to have rows appended to the filter too
+    const QString name = tree.nodes()[ full_log.nodeIndex(count - 1) ].instance_name;
+    filter_model.setFilter( ReplayFilterModel::parseFilter( name ) );
+    QSignalSpy inserted_spy( &filter_model, &ReplayFilterModel::rowsInserted );
+
+    QFile writer( file.fileName() );
+    QVERIFY( writer.open( QIODevice::WriteOnly | QIODevice::Append ) );
+
+    auto appendRecords = [&](int from, int to)
+    {
+        writer.write( content.mid( from, to - from ) );
+        writer.flush();
+    };
+
+    auto filteredRows = [&]()
+    {
+        std::vector<int> rows;
+        for (size_t row = 0; row < log->transitionsCount(); row++)
+        {
+            if( tree.nodes()[ log->nodeIndex(row) ].instance_name.contains( name, Qt::CaseInsensitive ) )
+            {
+                rows.push_back( static_cast<int>(row) );
+            }
+        }
+        return rows;
+    };
+
+    // one complete record and part of the next one
+    appendRecords( records_end(count - 3), records_end(count - 2) + 5 );
+    QCOMPARE( log->update(), size_t(1) );
+    QCOMPARE( log->transitionsCount(), count - 2 );
+    table_model.transitionsAppended();
+
+    // nothing new to decode until the record is complete
+    QCOMPARE( log->update(), size_t(0) );
+
+    appendRecords( records_end(count - 2) + 5, records_end(count) );
+    QCOMPARE( log->update(), size_t(2) );
+    QCOMPARE( log->transitionsCount(), count );
+    table_model.transitionsAppended();
+    QCOMPARE( table_model.rowCount(), static_cast<int>(count) );
+    QCOMPARE( unfiltered_model.rowCount(), static_cast<int>(count) );
+
+    for (size_t row = 0; row < count; row++)
+    {
+        QCOMPARE( log->timestamp(row), full_log.timestamp(row) );
+        QCOMPARE( log->nodeIndex(row), full_log.nodeIndex(row) );
+        QVERIFY( log->status(row) == full_log.status(row) );
+        QVERIFY( log->prevStatus(row) == full_log.prevStatus(row) );
+    }
+    QVERIFY( log->restarts() == full_log.restarts() );
+
+    // the rows accepted by the filter were appended, in order
+    const auto expected = filteredRows();
+    QCOMPARE( filter_model.rowCount(), static_cast<int>(expected.size()) );
+    for (int row = 0; row < filter_model.rowCount(); row++)
+    {
+        QCOMPARE( filter_model.mapToSource( filter_model.index(row, 0) ).row(), expected[row] );
+    }
+    QVERIFY( inserted_spy.count() > 0 );
+    QCOMPARE( inserted_spy.last().at(2).toInt(), filter_model.rowCount() - 1 );
+}
+
+void ReplyTest::columnarStore()
+{
+    const QByteArray& content = _crossdoor_trace;
+
+    ReplayLog log;
+    QVERIFY( openLog( log, content ) );
+
+    // compare the decoded columns with the records in the file
+    const char* data = content.constData();
+    const size_t offset = 4 + flatbuffers::ReadScalar<uint32_t>( data );
+    const size_t count = (content.size() - offset) / ReplayLog::TRANSITION_SIZE;
+    QCOMPARE( log.transitionsCount(), count );
+
+    for (size_t row = 0; row < count; row++)
+    {
+        const char* buffer = &data[ offset + row * ReplayLog::TRANSITION_SIZE ];
+        const double t_sec  = flatbuffers::ReadScalar<uint32_t>( &buffer[0] );
+        const double t_usec = flatbuffers::ReadScalar<uint32_t>( &buffer[4] );
+        const auto status = convert( flatbuffers::ReadScalar<Serialization::NodeStatus>( &buffer[11] ) );
+        const auto prev_status = convert( flatbuffers::ReadScalar<Serialization::NodeStatus>( &buffer[10] ) );
+
+        QCOMPARE( log.timestamp(row), t_sec + t_usec* 0.000001 );
+        QVERIFY( log.status(row) == status );
+        QVERIFY( log.prevStatus(row) == prev_status );
+    }
+}
+
+void ReplyTest::statistics()
+{
+    ReplayLog log;
+    QVERIFY( openLog( log, _crossdoor_trace ) );
+
+    ReplayStatistics statistics;
+    QVERIFY( statistics.process( log ) );
+    QCOMPARE( statistics.processedCount(), log.transitionsCount() );
+
+    const auto summary = statistics.summary();
+    QCOMPARE( summary.size(), log.nodesCount() );
+
+    for (size_t index = 0; index < log.nodesCount(); index++)
+    {
+        size_t ticks = 0;
+        size_t completed = 0;
+        for (uint32_t row: log.nodeRows(index))
+        {
+            if( log.prevStatus(row) == NodeStatus::IDLE && log.status(row) != NodeStatus::IDLE )
+            {
+                ticks++;
+            }
+            if( log.status(row) == NodeStatus::SUCCESS || log.status(row) == NodeStatus::FAILURE )
+            {
+                completed++;
+            }
+        }
+        QCOMPARE( summary[index].ticks, ticks );
+        QCOMPARE( summary[index].successes + summary[index].failures, completed );
+        QVERIFY( summary[index].latency_p50 <= summary[index].latency_p90 );
+        QVERIFY( summary[index].latency_p99 <= summary[index].latency_max );
+    }
+}
+
+void ReplyTest::compareLogs()
+{
+    const QByteArray& content = _crossdoor_trace;
+
+    ReplayLog log_a;
+    QVERIFY( openLog( log_a, content ) );
+
+    // identical
+    ReplayLog log_b;
+    QVERIFY( openLog( log_b, content ) );
+
+    ReplayDiff diff = CompareReplayLogs( log_a, log_b );
+    QVERIFY( !diff.diverged );
+    QCOMPARE( diff.unmatched_nodes, size_t(0) );
+    QCOMPARE( diff.ticks_diverging, size_t(0) );
+
+    for (size_t row = 0; row < log_a.transitionsCount(); row++)
+    {
+        QCOMPARE( AlignedReplayRow( log_a, log_b, row ), row );
+    }
+
+    // the second run stopped one transition earlier
+    ReplayLog log_c;
+    QVERIFY( openLog( log_c, content.left( content.size() - int(ReplayLog::TRANSITION_SIZE) ) ) );
+
+    diff = CompareReplayLogs( log_a, log_c );
+    QVERIFY( diff.diverged );
+    QCOMPARE( diff.row_a, log_a.transitionsCount() - 1 );
+    QCOMPARE( diff.row_b, log_c.transitionsCount() );
+}
+
+void ReplyTest::tickIndex()
+{
+    ReplayLog log;
+    QVERIFY( openLog( log, _crossdoor_trace ) );
+    QVERIFY( log.ticksCount() > 0 );
+
+    // ticks are contiguous and cover all the rows
+    QCOMPARE( log.tickStart(0), size_t(0) );
+    QCOMPARE( log.tickEnd( log.ticksCount() - 1 ), log.transitionsCount() );
+
+    for (size_t tick = 0; tick < log.ticksCount(); tick++)
+    {
+        QVERIFY( log.tickStart(tick) < log.tickEnd(tick) );
+        for (size_t row = log.tickStart(tick); row < log.tickEnd(tick); row++)
+        {
+            QCOMPARE( log.tickAt(row), tick );
+            QCOMPARE( log.nearestRestart(row) <= row, true );
+        }
+    }
+
+    const auto slowest = log.slowestTicks(3);
+    QCOMPARE( slowest.size(), std::min<size_t>( 3, log.ticksCount() ) );
+    for (size_t i = 1; i < slowest.size(); i++)
+    {
+        QVERIFY( log.tickDuration( slowest[i-1] ) >= log.tickDuration( slowest[i] ) );
+    }
+}
+
+void ReplyTest::streamDecode()
+{
+    const QByteArray& content = _crossdoor_trace;
+
+    ReplayLog log;
+    QVERIFY( openLog( log, content ) );
+
+    QTemporaryFile file;
+    QVERIFY( writeFile( file, content ) );
+
+    ReplayStream stream;
+    QVERIFY( stream.open( file.fileName() ) );
+    QCOMPARE( stream.nodesCount(), log.nodesCount() );
+    QCOMPARE( stream.recordsCount(), log.transitionsCount() );
+
+    // same transitions and restarts of ReplayLog
+    ReplayRecord record;
+    bool restart = false;
+    std::vector<uint32_t> restarts;
+    size_t row = 0;
+    while( stream.next( record, restart ) )
+    {
+        QCOMPARE( record.index, log.nodeIndex(row) );
+        QVERIFY( record.status == log.status(row) );
+        QVERIFY( record.prev_status == log.prevStatus(row) );
+        QCOMPARE( record.timestamp(), log.timestamp(row) );
+        if( restart )
+        {
+            restarts.push_back( static_cast<uint32_t>(row) );
+        }
+        row++;
+    }
+    QVERIFY( !stream.hasError() );
+    QCOMPARE( row, log.transitionsCount() );
+    QVERIFY( restarts == log.restarts() );
+
+    // percentiles are approximated within the width of a bucket
+    DurationHistogram histogram;
+    for (int i = 1; i <= 1000; i++)
+    {
+        histogram.add( i * 0.001 );
+    }
+    QCOMPARE( histogram.count(), size_t(1000) );
+    QCOMPARE( histogram.max(), 1.0 );
+    QVERIFY( std::abs( histogram.mean() - 0.5005 ) < 1e-9 );
+    QVERIFY( std::abs( histogram.percentile(0.5) - 0.5 ) < 0.5 * 0.05 );
+    QVERIFY( std::abs( histogram.percentile(0.9) - 0.9 ) < 0.9 * 0.05 );
+}
+
+void ReplyTest::archive()
+{
+    const QByteArray& content = _crossdoor_trace;
+
+    ReplayLog log;
+    QVERIFY( openLog( log, content ) );
+
+    QTemporaryFile file;
+    QVERIFY( writeFile( file, content ) );
+
+    // small chunks, to have more than one
+    QTemporaryFile archive_file;
+    QVERIFY( archive_file.open() );
+    archive_file.close();
+
+    ReplayStream stream;
+    QVERIFY( stream.open( file.fileName() ) );
+    ReplayArchiveWriter writer(4);
+    QVERIFY( writer.open( archive_file.fileName(), stream.header() ) );
+
+    ReplayRecord record;
+    bool restart = false;
+    while( stream.next( record, restart ) )
+    {
+        QVERIFY( writer.append( stream.lastRecord() ) );
+    }
+    QVERIFY( writer.close() );
+
+    ReplayArchive archive;
+    QVERIFY( archive.open( archive_file.fileName() ) );
+    QCOMPARE( archive.recordsCount(), log.transitionsCount() );
+    QCOMPARE( archive.nodesCount(), log.nodesCount() );
+    QCOMPARE( archive.chunks().size(), (log.transitionsCount() + 3) / 4 );
+
+    // streamed into ReplayLog, it is decoded exactly as the plain log
+    ReplayLog archived_log;
+    QVERIFY( archived_log.openFile( archive_file.fileName() ) );
+    QVERIFY( !archived_log.isMappedFile() );
+    QVERIFY( archived_log.buildIndex() );
+    // and again, from the first record
+    QVERIFY( archived_log.buildIndex() );
+    QCOMPARE( archived_log.transitionsCount(), log.transitionsCount() );
+    QVERIFY( archived_log.restarts() == log.restarts() );
+
+    // read sequentially, it gives back the plain log (as groot_log_tool --extract)
+    ReplayStream archive_stream;
+    QVERIFY( archive_stream.open( archive_file.fileName() ) );
+    QByteArray extracted = archive_stream.header();
+    while( archive_stream.next( record, restart ) )
+    {
+        extracted.append( archive_stream.lastRecord(), static_cast<int>(ReplayLog::TRANSITION_SIZE) );
+    }
+    QVERIFY( !archive_stream.hasError() );
+    QVERIFY( extracted == content );
+
+    for (size_t row = 0; row < log.transitionsCount(); row++)
+    {
+        QCOMPARE( archived_log.timestamp(row), log.timestamp(row) );
+        QCOMPARE( archived_log.nodeIndex(row), log.nodeIndex(row) );
+        QVERIFY( archived_log.status(row) == log.status(row) );
+        QVERIFY( archived_log.prevStatus(row) == log.prevStatus(row) );
+
+        // seeking with the snapshots gives the state after the last
+        // transition with the same timestamp
+        const double t = log.timestamp(row);
+        const size_t last_row = log.lowerBoundRow( std::nextafter( t, 1e300 ) ) - 1;
+        const auto expected = log.stateAt( last_row );
+
+        std::vector<ReplayNodeState> state;
+        QVERIFY( archive.stateAt( t, state ) );
+        QCOMPARE( state.size(), expected.size() );
+        for (size_t index = 0; index < state.size(); index++)
+        {
+            QVERIFY( state[index].status == expected[index].status );
+            QVERIFY( state[index].prev_status == expected[index].prev_status );
+        }
+    }
+}
+
+void ReplyTest::writeLog()
+{
+    const QByteArray& content = _crossdoor_trace;
+
+    ReplayLog log;
+    QVERIFY( openLog( log, content ) );
+
+    const size_t header_size = 4 + flatbuffers::ReadScalar<uint32_t>( content.constData() );
+    const char* records = content.constData() + header_size;
+
+    QTemporaryFile file;
+    QVERIFY( file.open() );
+    file.close();
+
+    // records appended in small batches, as received by the monitor
+    ReplayLogWriter writer;
+    writer.open( file.fileName(), content.left( static_cast<int>(header_size) ) );
+    for (size_t row = 0; row < log.transitionsCount(); row += 2)
+    {
+        const size_t count = std::min<size_t>( 2, log.transitionsCount() - row );
+        writer.append( records + row * ReplayLog::TRANSITION_SIZE, count );
+    }
+    writer.close();
+    QVERIFY( !writer.hasError() );
+    QCOMPARE( writer.recordsWritten(), log.transitionsCount() );
+    QCOMPARE( writer.droppedRecords(), size_t(0) );
+
+    QFile written( file.fileName() );
+    QVERIFY( written.open(QIODevice::ReadOnly) );
+    QVERIFY( written.readAll() == content );
+}
+
 QTEST_MAIN(ReplyTest)
 
 #include "replay_test.moc"
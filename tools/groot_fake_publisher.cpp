@@ -0,0 +1,587 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDomDocument>
+#include <QFile>
+#include <QTextStream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+#include <zmq.hpp>
+
+#include <behaviortree_cpp_v3/flatbuffers/BT_logger_generated.h>
+
+/*
+ * Stand-in for the ZMQ publisher of a robot (PublisherZMQ), to exercise the
+ * monitor without one:
+ *
+ *     groot_fake_publisher [--rate R] [--burst B] [--nodes N] [--copies K] [file.xml]
+ *
+ * The tree is read from the XML (the main tree, with its subtrees expanded)
+ * or generated with N nodes. The server replies with the tree, as a flatbuffer,
+ * and every tick of a simulated execution is published as a message.
+ */
+
+namespace {
+
+const size_t NO_PARENT = size_t(-1);
+
+struct FakeNode{
+    std::string instance_name;
+    std::string registration_name;
+    Serialization::NodeType type;
+    std::vector<std::pair<std::string,std::string>> ports;
+    // indices in FakeTree::nodes
+    std::vector<size_t> children;
+};
+
+// Nodes in depth-first order: the uid of nodes[i] is i+1, the root is nodes[0].
+struct FakeTree{
+    std::vector<FakeNode> nodes;
+
+    size_t add(FakeNode node)
+    {
+        nodes.push_back( std::move(node) );
+        return nodes.size() - 1;
+    }
+};
+
+Serialization::NodeType BuiltinType(const QString& tag)
+{
+    static const std::set<QString> controls = {
+        "Sequence", "SequenceStar", "ReactiveSequence", "Fallback", "ReactiveFallback",
+        "Parallel", "IfThenElse", "WhileDoElse", "Switch2", "Switch3", "Switch4",
+        "Switch5", "Switch6", "Control" };
+    static const std::set<QString> decorators = {
+        "Inverter", "RetryUntilSuccesful", "RetryUntilSuccessful", "Repeat", "Timeout",
+        "Delay", "ForceSuccess", "ForceFailure", "KeepRunningUntilFailure",
+        "BlackboardCheckInt", "BlackboardCheckDouble", "BlackboardCheckString", "Decorator" };
+
+    if( controls.count(tag) )   return Serialization::NodeType::CONTROL;
+    if( decorators.count(tag) ) return Serialization::NodeType::DECORATOR;
+    if( tag == "Condition" )    return Serialization::NodeType::CONDITION;
+    if( tag == "SubTree" || tag == "SubTreePlus" ) return Serialization::NodeType::SUBTREE;
+    if( tag == "Action" )       return Serialization::NodeType::ACTION;
+    return Serialization::NodeType::UNDEFINED;
+}
+
+class TreeLoader
+{
+public:
+    bool load(const QString& file_name, FakeTree& tree, size_t root_parent, QString& error)
+    {
+        QFile file( file_name );
+        if( !file.open(QIODevice::ReadOnly) )
+        {
+            error = file.errorString();
+            return false;
+        }
+        QString parse_error;
+        if( !_document.setContent( &file, &parse_error ) )
+        {
+            error = parse_error;
+            return false;
+        }
+        const QDomElement root = _document.documentElement();
+
+        // types declared in <TreeNodesModel>
+        const QDomElement models = root.firstChildElement("TreeNodesModel");
+        for (QDomElement model = models.firstChildElement(); !model.isNull();
+             model = model.nextSiblingElement())
+        {
+            _model_types[ model.attribute("ID") ] = BuiltinType( model.tagName() );
+        }
+
+        QString main_tree = root.attribute("main_tree_to_execute");
+        for (QDomElement bt = root.firstChildElement("BehaviorTree"); !bt.isNull();
+             bt = bt.nextSiblingElement("BehaviorTree"))
+        {
+            const QString ID = bt.attribute("ID", "BehaviorTree");
+            _trees[ID] = bt;
+            if( main_tree.isEmpty() )
+            {
+                main_tree = ID;
+            }
+        }
+        if( _trees.count(main_tree) == 0 )
+        {
+            error = QString("no <BehaviorTree> called %1").arg(main_tree);
+            return false;
+        }
+        return addTree( _trees[main_tree], tree, root_parent, error );
+    }
+
+private:
+
+    bool addTree(QDomElement bt, FakeTree& tree, size_t parent, QString& error)
+    {
+        QDomElement first = bt.firstChildElement();
+        if( first.tagName() == "Root" )
+        {
+            first = first.firstChildElement();
+        }
+        if( first.isNull() )
+        {
+            error = QString("empty <BehaviorTree> %1").arg( bt.attribute("ID") );
+            return false;
+        }
+        return addNode( first, tree, parent, error );
+    }
+
+    bool addNode(QDomElement element, FakeTree& tree, size_t parent, QString& error)
+    {
+        FakeNode node;
+        const QString ID = element.attribute( "ID", element.tagName() );
+        node.registration_name = ID.toStdString();
+        node.instance_name = element.attribute( "name", ID ).toStdString();
+
+        node.type = BuiltinType( element.tagName() );
+        if( node.type == Serialization::NodeType::UNDEFINED || element.hasAttribute("ID") )
+        {
+            auto it = _model_types.find(ID);
+            if( it != _model_types.end() )
+            {
+                node.type = it->second;
+            }
+        }
+        if( node.type == Serialization::NodeType::UNDEFINED )
+        {
+            int children = 0;
+            for (QDomElement child = element.firstChildElement(); !child.isNull();
+                 child = child.nextSiblingElement())
+            {
+                children++;
+            }
+            node.type = children == 0 ? Serialization::NodeType::ACTION :
+                        children == 1 ? Serialization::NodeType::DECORATOR :
+                                        Serialization::NodeType::CONTROL;
+        }
+
+        const auto attributes = element.attributes();
+        for (int i = 0; i < attributes.size(); i++)
+        {
+            const auto attribute = attributes.item(i).toAttr();
+            if( attribute.name() != "ID" && attribute.name() != "name" )
+            {
+                node.ports.push_back( { attribute.name().toStdString(),
+                                        attribute.value().toStdString() } );
+            }
+        }
+
+        const size_t index = tree.add( std::move(node) );
+        if( parent != NO_PARENT )
+        {
+            tree.nodes[parent].children.push_back( index );
+        }
+
+        // subtrees are expanded, as done by BT::Tree
+        if( tree.nodes[index].type == Serialization::NodeType::SUBTREE )
+        {
+            if( _trees.count(ID) == 0 || _expanding.count(ID) )
+            {
+                error = QString("the subtree %1 is missing or recursive").arg(ID);
+                return false;
+            }
+            _expanding.insert(ID);
+            const bool ok = addTree( _trees[ID], tree, index, error );
+            _expanding.erase(ID);
+            return ok;
+        }
+
+        for (QDomElement child = element.firstChildElement(); !child.isNull();
+             child = child.nextSiblingElement())
+        {
+            if( !addNode( child, tree, index, error ) )
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    QDomDocument _document;
+    std::map<QString, QDomElement> _trees;
+    std::map<QString, Serialization::NodeType> _model_types;
+    std::set<QString> _expanding;
+};
+
+// Sequences with "fanout" children, down to the actions.
+void GenerateTree(FakeTree& tree, size_t parent, size_t nodes_count, size_t fanout)
+{
+    FakeNode node;
+    const bool leaf = nodes_count <= 1;
+    node.registration_name = leaf ? "FakeAction" : "Sequence";
+    node.instance_name = node.registration_name;
+    node.type = leaf ? Serialization::NodeType::ACTION : Serialization::NodeType::CONTROL;
+    const size_t index = tree.add( std::move(node) );
+    if( parent != NO_PARENT )
+    {
+        tree.nodes[parent].children.push_back( index );
+    }
+
+    // the other nodes are split among the children
+    size_t remaining = nodes_count - 1;
+    const size_t children = std::min( fanout, remaining );
+    for (size_t i = 0; i < children; i++)
+    {
+        const size_t size = remaining / (children - i);
+        GenerateTree( tree, index, size, fanout );
+        remaining -= size;
+    }
+}
+
+// The reply of the server, as created by BT::CreateFlatbuffersBehaviorTree()
+QByteArray SerializeTree(const FakeTree& tree)
+{
+    flatbuffers::FlatBufferBuilder builder(1024);
+
+    std::vector<flatbuffers::Offset<Serialization::TreeNode>> fb_nodes;
+    std::map<std::string, size_t> models;
+    std::vector<flatbuffers::Offset<Serialization::NodeModel>> fb_models;
+
+    for (size_t i = 0; i < tree.nodes.size(); i++)
+    {
+        const FakeNode& node = tree.nodes[i];
+
+        std::vector<uint16_t> children_uid;
+        for (size_t child: node.children)
+        {
+            children_uid.push_back( static_cast<uint16_t>(child + 1) );
+        }
+
+        std::vector<flatbuffers::Offset<Serialization::PortConfig>> ports;
+        for (const auto& port: node.ports)
+        {
+            ports.push_back( Serialization::CreatePortConfig( builder,
+                                                              builder.CreateString(port.first),
+                                                              builder.CreateString(port.second) ) );
+        }
+
+        fb_nodes.push_back( Serialization::CreateTreeNode(
+                                builder, static_cast<uint16_t>(i + 1),
+                                builder.CreateVector(children_uid),
+                                Serialization::NodeStatus::IDLE,
+                                builder.CreateString(node.instance_name),
+                                builder.CreateString(node.registration_name),
+                                builder.CreateVector(ports) ) );
+
+        if( models.count(node.registration_name) == 0 )
+        {
+            models[node.registration_name] = fb_models.size();
+
+            std::vector<flatbuffers::Offset<Serialization::PortModel>> port_models;
+            for (const auto& port: node.ports)
+            {
+                port_models.push_back( Serialization::CreatePortModel(
+                                           builder, builder.CreateString(port.first),
+                                           Serialization::PortDirection::INOUT,
+                                           builder.CreateString(""),
+                                           builder.CreateString("") ) );
+            }
+            fb_models.push_back( Serialization::CreateNodeModel(
+                                     builder, builder.CreateString(node.registration_name),
+                                     node.type, builder.CreateVector(port_models) ) );
+        }
+    }
+
+    auto behavior_tree = Serialization::CreateBehaviorTree( builder, 1,
+                                                            builder.CreateVector(fb_nodes),
+                                                            builder.CreateVector(fb_models) );
+    builder.Finish( behavior_tree );
+    return QByteArray( reinterpret_cast<const char*>( builder.GetBufferPointer() ),
+                       static_cast<int>( builder.GetSize() ) );
+}
+
+/**
+ * Simulated execution: every node is ticked as a Sequence, i.e. its children
+ * are ticked in order until one of them fails. Actions fail with the given
+ * probability. The children are halted (IDLE) before their parent completes.
+ */
+class FakeExecution
+{
+public:
+    FakeExecution(const FakeTree& tree, double failure_probability):
+        _tree(tree),
+        _status( tree.nodes.size(), Serialization::NodeStatus::IDLE ),
+        _failure( failure_probability )
+    {}
+
+    // the message of PublisherZMQ for one tick
+    void tick(std::vector<char>& message)
+    {
+        _transitions.clear();
+        const auto now = std::chrono::system_clock::now().time_since_epoch();
+        const auto usec = std::chrono::duration_cast<std::chrono::microseconds>( now ).count();
+        _sec  = static_cast<uint32_t>( usec / 1000000 );
+        _usec = static_cast<uint32_t>( usec % 1000000 );
+
+        tickNode( 0 );
+
+        const uint32_t header_size = static_cast<uint32_t>( 3 * _tree.nodes.size() );
+        const uint32_t transitions_count = static_cast<uint32_t>( _transitions.size() / 12 );
+        message.resize( 4 + header_size + 4 + _transitions.size() );
+
+        char* ptr = message.data();
+        std::memcpy( ptr, &header_size, 4 );
+        ptr += 4;
+        for (size_t i = 0; i < _tree.nodes.size(); i++)
+        {
+            const uint16_t uid = static_cast<uint16_t>(i + 1);
+            std::memcpy( ptr, &uid, 2 );
+            ptr[2] = static_cast<char>( _status[i] );
+            ptr += 3;
+        }
+        std::memcpy( ptr, &transitions_count, 4 );
+        ptr += 4;
+        std::memcpy( ptr, _transitions.data(), _transitions.size() );
+    }
+
+private:
+
+    void setStatus(size_t index, Serialization::NodeStatus status)
+    {
+        // same layout of a .fbl record
+        char record[12];
+        const uint16_t uid = static_cast<uint16_t>(index + 1);
+        std::memcpy( &record[0], &_sec, 4 );
+        std::memcpy( &record[4], &_usec, 4 );
+        std::memcpy( &record[8], &uid, 2 );
+        record[10] = static_cast<char>( _status[index] );
+        record[11] = static_cast<char>( status );
+        _transitions.insert( _transitions.end(), record, record + 12 );
+        _status[index] = status;
+    }
+
+    Serialization::NodeStatus tickNode(size_t index)
+    {
+        const FakeNode& node = _tree.nodes[index];
+        setStatus( index, Serialization::NodeStatus::RUNNING );
+
+        Serialization::NodeStatus result = Serialization::NodeStatus::SUCCESS;
+        if( node.children.empty() )
+        {
+            if( _distribution(_generator) < _failure )
+            {
+                result = Serialization::NodeStatus::FAILURE;
+            }
+        }
+        else{
+            size_t ticked = 0;
+            for (size_t child: node.children)
+            {
+                ticked++;
+                if( tickNode( child ) == Serialization::NodeStatus::FAILURE )
+                {
+                    result = Serialization::NodeStatus::FAILURE;
+                    break;
+                }
+            }
+            for (size_t i = 0; i < ticked; i++)
+            {
+                setStatus( node.children[i], Serialization::NodeStatus::IDLE );
+            }
+        }
+        setStatus( index, result );
+        return result;
+    }
+
+    const FakeTree& _tree;
+    std::vector<Serialization::NodeStatus> _status;
+    std::vector<char> _transitions;
+    uint32_t _sec;
+    uint32_t _usec;
+
+    double _failure;
+    std::mt19937 _generator;
+    std::uniform_real_distribution<double> _distribution;
+};
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("groot_fake_publisher");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Publish the execution of a fake behavior tree, "
+                                     "as a robot does, to test the monitor");
+    parser.addHelpOption();
+    parser.addPositionalArgument("file", "The XML of the tree. If missing, the tree is generated");
+
+    QCommandLineOption rate_option(QStringList() << "r" << "rate",
+                                   "Ticks (i.e. messages) per second. Default 50",
+                                   "R", "50");
+    parser.addOption(rate_option);
+
+    QCommandLineOption burst_option(QStringList() << "b" << "burst",
+                                    "Messages sent back to back, at the same average rate. Default 1",
+                                    "B", "1");
+    parser.addOption(burst_option);
+
+    QCommandLineOption nodes_option(QStringList() << "n" << "nodes",
+                                    "Nodes of the generated tree, without a file. Default 100",
+                                    "N", "100");
+    parser.addOption(nodes_option);
+
+    QCommandLineOption copies_option(QStringList() << "c" << "copies",
+                                     "Copies of the tree, children of the same Sequence. Default 1",
+                                     "K", "1");
+    parser.addOption(copies_option);
+
+    QCommandLineOption failure_option(QStringList() << "failure",
+                                      "Probability that an action fails. Default 0.05",
+                                      "P", "0.05");
+    parser.addOption(failure_option);
+
+    QCommandLineOption duration_option(QStringList() << "d" << "duration",
+                                       "Seconds, then exit. Default 0, i.e. forever",
+                                       "S", "0");
+    parser.addOption(duration_option);
+
+    QCommandLineOption publisher_option(QStringList() << "publisher-port",
+                                        "Default 1666", "port", "1666");
+    parser.addOption(publisher_option);
+
+    QCommandLineOption server_option(QStringList() << "server-port",
+                                     "Default 1667", "port", "1667");
+    parser.addOption(server_option);
+    parser.process( app );
+
+    QTextStream err(stderr);
+
+    bool ok_rate = false, ok_burst = false, ok_nodes = false, ok_copies = false;
+    bool ok_failure = false, ok_duration = false;
+    const double rate     = parser.value(rate_option).toDouble(&ok_rate);
+    const int burst       = parser.value(burst_option).toInt(&ok_burst);
+    const int nodes_count = parser.value(nodes_option).toInt(&ok_nodes);
+    const int copies      = parser.value(copies_option).toInt(&ok_copies);
+    const double failure  = parser.value(failure_option).toDouble(&ok_failure);
+    const double duration = parser.value(duration_option).toDouble(&ok_duration);
+
+    if( !ok_rate || rate <= 0 || !ok_burst || burst < 1 || !ok_nodes || nodes_count < 1 ||
+        !ok_copies || copies < 1 || !ok_failure || !ok_duration )
+    {
+        err << "wrong value of an option, see --help" << "\n";
+        return 1;
+    }
+    if( parser.positionalArguments().size() > 1 )
+    {
+        parser.showHelp(1);
+    }
+
+    FakeTree tree;
+    size_t parent = NO_PARENT;
+    if( copies > 1 )
+    {
+        FakeNode root;
+        root.registration_name = "Sequence";
+        root.instance_name = "Copies";
+        root.type = Serialization::NodeType::CONTROL;
+        parent = tree.add( std::move(root) );
+    }
+    for (int copy = 0; copy < copies; copy++)
+    {
+        if( parser.positionalArguments().empty() )
+        {
+            GenerateTree( tree, parent, static_cast<size_t>(nodes_count), 4 );
+            continue;
+        }
+        QString error;
+        TreeLoader loader;
+        if( !loader.load( parser.positionalArguments().front(), tree, parent, error ) )
+        {
+            err << parser.positionalArguments().front() << ": " << error << "\n";
+            return 1;
+        }
+    }
+    if( tree.nodes.size() > 65535 )
+    {
+        err << "too many nodes: the uids are 16 bits" << "\n";
+        return 1;
+    }
+
+    const QByteArray tree_buffer = SerializeTree( tree );
+
+    zmq::context_t context(1);
+    zmq::socket_t publisher( context, ZMQ_PUB );
+    zmq::socket_t server( context, ZMQ_REP );
+    try{
+        publisher.bind( ("tcp://*:" + parser.value(publisher_option)).toStdString().c_str() );
+        server.bind( ("tcp://*:" + parser.value(server_option)).toStdString().c_str() );
+    }
+    catch( zmq::error_t& error )
+    {
+        err << "can't bind: " << error.what() << "\n";
+        return 1;
+    }
+
+    // the tree is sent to any request, as done by PublisherZMQ
+    std::atomic<bool> stop( false );
+    std::thread server_thread( [&]()
+    {
+        int timeout_ms = 100;
+        server.setsockopt(ZMQ_RCVTIMEO, &timeout_ms, sizeof(int) );
+        while( !stop )
+        {
+            zmq::message_t request;
+            try{
+                if( server.recv(&request) )
+                {
+                    zmq::message_t reply( tree_buffer.constData(), static_cast<size_t>( tree_buffer.size() ) );
+                    server.send(reply);
+                }
+            }
+            catch( zmq::error_t& ) {}
+        }
+    });
+
+    err << "Publishing " << tree.nodes.size() << " nodes, " << rate << " ticks/s\n";
+    err.flush();
+
+    FakeExecution execution( tree, failure );
+    std::vector<char> message;
+    size_t messages = 0;
+    size_t bytes = 0;
+
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    auto last_report = start;
+    const std::chrono::duration<double> burst_period( burst / rate );
+
+    for (size_t sent_bursts = 0; ; sent_bursts++)
+    {
+        const auto now = Clock::now();
+        if( duration > 0 && std::chrono::duration<double>( now - start ).count() >= duration )
+        {
+            break;
+        }
+        std::this_thread::sleep_until( start + std::chrono::duration_cast<Clock::duration>(
+                                           burst_period * static_cast<double>(sent_bursts) ) );
+
+        for (int i = 0; i < burst; i++)
+        {
+            execution.tick( message );
+            zmq::message_t zmq_message( message.data(), message.size() );
+            publisher.send( zmq_message );
+            messages++;
+            bytes += message.size();
+        }
+
+        if( Clock::now() - last_report >= std::chrono::seconds(1) )
+        {
+            last_report = Clock::now();
+            err << "sent " << messages << " messages, " << bytes / 1024 << " KB\n";
+            err.flush();
+        }
+    }
+
+    stop = true;
+    server_thread.join();
+    return 0;
+}
@@ -0,0 +1,419 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+#include "bt_editor/replay_archive.h"
+#include "bt_editor/replay_stream.h"
+#include "bt_editor/replay_statistics.h"
+
+/*
+ * Summary of a .fbl log, printed as JSON or CSV:
+ *
+ *     groot_log_tool [--format json|csv] [--ticks] [--slowest N]
+ *                    [--archive out.fblz] [--extract out.fbl] file.fbl|file.fblz
+ *
+ * The CSV summary has three sections, separated by an empty line: the nodes,
+ * the durations of the ticks and the slowest ticks. With --ticks, one row
+ * (or one JSON object) per tick is printed instead.
+ *
+ * The log is read sequentially, once: memory doesn't depend on its size.
+ * With --archive, it is also converted into a chunked archive (see ReplayArchive).
+ * With --extract, an archive is converted back into a plain log, that can be replayed.
+ */
+
+namespace {
+
+struct TickSummary{
+    size_t tick;
+    size_t start_row;
+    double start_time;
+    double duration;
+    NodeStatus status;
+};
+
+// min-heap on the duration, i.e. the top is the fastest of the slowest ticks
+struct FasterTick{
+    bool operator()(const TickSummary& a, const TickSummary& b) const
+    {
+        return a.duration > b.duration;
+    }
+};
+
+const char* typeName(Serialization::NodeType type)
+{
+    switch( type )
+    {
+    case Serialization::NodeType::UNDEFINED: return "UNDEFINED";
+    case Serialization::NodeType::ACTION:    return "ACTION";
+    case Serialization::NodeType::CONDITION: return "CONDITION";
+    case Serialization::NodeType::CONTROL:   return "CONTROL";
+    case Serialization::NodeType::DECORATOR: return "DECORATOR";
+    case Serialization::NodeType::SUBTREE:   return "SUBTREE";
+    }
+    return "";
+}
+
+const char* statusName(NodeStatus status)
+{
+    switch( status )
+    {
+    case NodeStatus::IDLE:    return "IDLE";
+    case NodeStatus::RUNNING: return "RUNNING";
+    case NodeStatus::SUCCESS: return "SUCCESS";
+    case NodeStatus::FAILURE: return "FAILURE";
+    }
+    return "";
+}
+
+QString csvField(QString text)
+{
+    if( text.contains(',') || text.contains('"') )
+    {
+        text.replace("\"", "\"\"");
+        return "\"" + text + "\"";
+    }
+    return text;
+}
+
+QJsonValue optionalTime(double t)
+{
+    return t < 0 ? QJsonValue() : QJsonValue(t);
+}
+
+const char* TICK_CSV_HEADER = "tick,start_row,start_time,duration,status\n";
+
+void printTickCsv(QTextStream& out, const TickSummary& tick)
+{
+    out << tick.tick << ',' << tick.start_row << ','
+        << QString::number( tick.start_time, 'f', 6 ) << ','
+        << QString::number( tick.duration, 'f', 6 ) << ','
+        << statusName( tick.status ) << '\n';
+}
+
+QJsonObject tickJson(const TickSummary& tick)
+{
+    QJsonObject tick_json;
+    tick_json["tick"]       = static_cast<double>( tick.tick );
+    tick_json["start_row"]  = static_cast<double>( tick.start_row );
+    tick_json["start_time"] = tick.start_time;
+    tick_json["duration"]   = tick.duration;
+    tick_json["status"]     = statusName( tick.status );
+    return tick_json;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("groot_log_tool");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Per-node statistics and tick durations of a Groot log (.fbl)");
+    parser.addHelpOption();
+    parser.addPositionalArgument("file", "The .fbl log, or the .fblz archive, to read");
+
+    QCommandLineOption format_option(QStringList() << "f" << "format",
+                                     "Output format: [json,csv]. Default json",
+                                     "format", "json");
+    parser.addOption(format_option);
+
+    QCommandLineOption ticks_option(QStringList() << "ticks",
+                                    "Print one row per tick instead of the summary");
+    parser.addOption(ticks_option);
+
+    QCommandLineOption slowest_option(QStringList() << "slowest",
+                                      "Number of slowest ticks in the summary. Default 10",
+                                      "N", "10");
+    parser.addOption(slowest_option);
+
+    QCommandLineOption archive_option(QStringList() << "archive",
+                                      "Write the log as a compressed, seekable archive too",
+                                      "file");
+    parser.addOption(archive_option);
+
+    QCommandLineOption extract_option(QStringList() << "extract",
+                                      "Write the log as a plain .fbl file too, e.g. to replay an archive",
+                                      "file");
+    parser.addOption(extract_option);
+    parser.process( app );
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    const QString format = parser.value(format_option);
+    if( format != "json" && format != "csv" )
+    {
+        err << "wrong format passed to --format. Use one of these: json / csv" << "\n";
+        return 1;
+    }
+    if( parser.positionalArguments().size() != 1 )
+    {
+        parser.showHelp(1);
+    }
+    bool slowest_ok = false;
+    const int slowest_value = parser.value(slowest_option).toInt(&slowest_ok);
+    if( !slowest_ok || slowest_value <= 0 )
+    {
+        err << "--slowest expects a positive number" << "\n";
+        return 1;
+    }
+    const size_t slowest_count = static_cast<size_t>( slowest_value );
+
+    const QString file_name = parser.positionalArguments().front();
+    ReplayStream stream;
+    if( !stream.open( file_name ) )
+    {
+        err << file_name << ": " << stream.errorString() << "\n";
+        return 1;
+    }
+
+    ReplayArchiveWriter archive;
+    const bool write_archive = parser.isSet(archive_option);
+    if( write_archive && !archive.open( parser.value(archive_option), stream.header() ) )
+    {
+        err << parser.value(archive_option) << ": " << archive.errorString() << "\n";
+        return 1;
+    }
+
+    QFile extract;
+    const bool write_extract = parser.isSet(extract_option);
+    if( write_extract )
+    {
+        extract.setFileName( parser.value(extract_option) );
+        if( !extract.open( QIODevice::WriteOnly | QIODevice::Truncate ) ||
+            extract.write( stream.header() ) != stream.header().size() )
+        {
+            err << extract.fileName() << ": " << extract.errorString() << "\n";
+            return 1;
+        }
+    }
+
+    const bool print_ticks = parser.isSet(ticks_option);
+    if( print_ticks && format == "csv" )
+    {
+        out << TICK_CSV_HEADER;
+    }
+
+    ReplayStatistics statistics( stream.nodesCount() );
+    DurationHistogram tick_durations;
+    std::priority_queue<TickSummary, std::vector<TickSummary>, FasterTick> slowest;
+    size_t failed_ticks = 0;
+
+    TickSummary tick = { 0, 0, 0, 0, NodeStatus::IDLE };
+    double last_time = 0;
+    bool tick_open = false;
+
+    auto closeTick = [&]()
+    {
+        tick.duration = last_time - tick.start_time;
+        tick_durations.add( tick.duration );
+        if( tick.status == NodeStatus::FAILURE )
+        {
+            failed_ticks++;
+        }
+        if( print_ticks && format == "csv" )
+        {
+            printTickCsv( out, tick );
+        }
+        else if( print_ticks )
+        {
+            // an array written one tick at a time: memory doesn't depend on the log
+            out << (tick.tick == 0 ? "[\n" : ",\n")
+                << QJsonDocument( tickJson(tick) ).toJson( QJsonDocument::Compact );
+        }
+        if( slowest.size() < slowest_count )
+        {
+            slowest.push( tick );
+        }
+        else if( slowest.top().duration < tick.duration )
+        {
+            slowest.pop();
+            slowest.push( tick );
+        }
+    };
+
+    ReplayRecord record;
+    bool restart = false;
+    while( stream.next( record, restart ) )
+    {
+        const size_t row = stream.position() - 1;
+        const double t = record.timestamp();
+
+        // the rows before the first restart are a tick too, as in ReplayLog
+        if( restart || !tick_open )
+        {
+            if( tick_open )
+            {
+                closeTick();
+                tick.tick++;
+            }
+            tick.start_row  = row;
+            tick.start_time = t;
+            tick.status     = NodeStatus::IDLE;
+            tick_open = true;
+        }
+        // the first node of the tree (index 1) gives the result of the tick
+        if( record.index == 1 && record.status != NodeStatus::IDLE )
+        {
+            tick.status = record.status;
+        }
+        last_time = t;
+        statistics.add( record.index, record.prev_status, record.status, t );
+
+        if( write_archive && !archive.append( stream.lastRecord() ) )
+        {
+            err << parser.value(archive_option) << ": " << archive.errorString() << "\n";
+            return 1;
+        }
+        if( write_extract &&
+            extract.write( stream.lastRecord(), REPLAY_RECORD_SIZE ) != qint64(REPLAY_RECORD_SIZE) )
+        {
+            err << extract.fileName() << ": " << extract.errorString() << "\n";
+            return 1;
+        }
+    }
+    if( stream.hasError() )
+    {
+        err << file_name << ": " << stream.errorString() << "\n";
+        return 1;
+    }
+    if( tick_open )
+    {
+        closeTick();
+    }
+    if( write_archive && !archive.close() )
+    {
+        err << parser.value(archive_option) << ": " << archive.errorString() << "\n";
+        return 1;
+    }
+    if( write_extract && !extract.flush() )
+    {
+        err << extract.fileName() << ": " << extract.errorString() << "\n";
+        return 1;
+    }
+    if( print_ticks )
+    {
+        if( format == "json" )
+        {
+            out << (tick_open ? "\n]\n" : "[]\n");
+        }
+        return 0;
+    }
+
+    const auto fb_nodes = stream.behaviorTree()->nodes();
+    const auto summary = statistics.summary();
+
+    auto nodeName = [&fb_nodes](size_t index) -> QString
+    {
+        return QString( fb_nodes->Get( static_cast<flatbuffers::uoffset_t>(index - 1) )->instance_name()->c_str() );
+    };
+    // the registration ID, e.g. "OpenDoor"
+    auto nodeModel = [&fb_nodes](size_t index) -> QString
+    {
+        return QString( fb_nodes->Get( static_cast<flatbuffers::uoffset_t>(index - 1) )->registration_name()->c_str() );
+    };
+    // ACTION, CONDITION, CONTROL, DECORATOR or SUBTREE
+    auto nodeType = [&fb_nodes](size_t index) -> QString
+    {
+        return typeName( fb_nodes->Get( static_cast<flatbuffers::uoffset_t>(index - 1) )->type() );
+    };
+
+    // from the slowest
+    std::vector<TickSummary> slowest_ticks;
+    while( !slowest.empty() )
+    {
+        slowest_ticks.push_back( slowest.top() );
+        slowest.pop();
+    }
+    std::reverse( slowest_ticks.begin(), slowest_ticks.end() );
+
+    if( format == "csv" )
+    {
+        out << "index,name,model,type,ticks,successes,failures,running_time,"
+               "latency_mean,latency_p50,latency_p90,latency_p99,latency_max,first_failure\n";
+        // index 0 is the Root added by BuildTreeFromFlatbuffers: it has no transitions
+        for (size_t index = 1; index < summary.size(); index++)
+        {
+            const auto& node = summary[index];
+            out << index << ',' << csvField( nodeName(index) ) << ','
+                << csvField( nodeModel(index) ) << ',' << nodeType(index) << ','
+                << node.ticks << ',' << node.successes << ',' << node.failures << ','
+                << node.running_time << ',' << node.latency_mean << ','
+                << node.latency_p50 << ',' << node.latency_p90 << ','
+                << node.latency_p99 << ',' << node.latency_max << ',';
+            if( node.first_failure >= 0 )
+            {
+                out << QString::number( node.first_failure, 'f', 6 );
+            }
+            out << '\n';
+        }
+
+        out << "\ncount,failed,duration_mean,duration_p50,duration_p90,duration_p99,duration_max\n";
+        out << tick_durations.count() << ',' << failed_ticks << ','
+            << tick_durations.mean() << ',' << tick_durations.percentile( 0.50 ) << ','
+            << tick_durations.percentile( 0.90 ) << ',' << tick_durations.percentile( 0.99 ) << ','
+            << tick_durations.max() << '\n';
+
+        out << '\n' << TICK_CSV_HEADER;
+        for (const auto& slow_tick: slowest_ticks)
+        {
+            printTickCsv( out, slow_tick );
+        }
+        return 0;
+    }
+
+    QJsonArray slowest_json;
+    for (const auto& slow_tick: slowest_ticks)
+    {
+        slowest_json.append( tickJson(slow_tick) );
+    }
+
+    QJsonObject ticks_json;
+    ticks_json["count"]         = static_cast<double>( tick_durations.count() );
+    ticks_json["failed"]        = static_cast<double>( failed_ticks );
+    ticks_json["duration_mean"] = tick_durations.mean();
+    ticks_json["duration_p50"]  = tick_durations.percentile( 0.50 );
+    ticks_json["duration_p90"]  = tick_durations.percentile( 0.90 );
+    ticks_json["duration_p99"]  = tick_durations.percentile( 0.99 );
+    ticks_json["duration_max"]  = tick_durations.max();
+    ticks_json["slowest"]       = slowest_json;
+
+    QJsonArray nodes_json;
+    for (size_t index = 1; index < summary.size(); index++)
+    {
+        const auto& node = summary[index];
+        QJsonObject node_json;
+        node_json["index"]         = static_cast<double>( index );
+        node_json["name"]          = nodeName(index);
+        node_json["model"]         = nodeModel(index);
+        node_json["type"]          = nodeType(index);
+        node_json["ticks"]         = static_cast<double>( node.ticks );
+        node_json["successes"]     = static_cast<double>( node.successes );
+        node_json["failures"]      = static_cast<double>( node.failures );
+        node_json["running_time"]  = node.running_time;
+        node_json["latency_mean"]  = node.latency_mean;
+        node_json["latency_p50"]   = node.latency_p50;
+        node_json["latency_p90"]   = node.latency_p90;
+        node_json["latency_p99"]   = node.latency_p99;
+        node_json["latency_max"]   = node.latency_max;
+        node_json["first_failure"] = optionalTime( node.first_failure );
+        nodes_json.append( node_json );
+    }
+
+    QJsonObject root;
+    root["file"]        = file_name;
+    root["transitions"] = static_cast<double>( stream.position() );
+    root["ticks"]       = ticks_json;
+    root["nodes"]       = nodes_json;
+
+    out << QJsonDocument(root).toJson();
+    return 0;
+}
@@ -0,0 +1,195 @@
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QProcess>
+#include <QTextStream>
+#include <QThread>
+
+#include "bt_editor/mainwindow.h"
+#include "bt_editor/monitor_connection.h"
+#include "bt_editor/replay_statistics.h"
+
+/*
+ * Sustained ingest rate and frame time of the monitor, against groot_fake_publisher:
+ *
+ *     groot_monitor_benchmark [--duration S] [--rate R] [--burst B] [--nodes N] [file.xml]
+ *
+ * The publisher is started as a child process, with the same options. Every frame
+ * does what SidepanelMonitor does for a visible robot (processMessages() and the
+ * update of the scene), then lets Qt paint. Frames are 20 ms apart, as in the monitor.
+ */
+
+namespace {
+
+void PrintHistogram(QTextStream& out, const char* name, const DurationHistogram& histogram)
+{
+    out << name << " [ms]: mean " << QString::number( histogram.mean() * 1000.0, 'f', 3 )
+        << "  p50 " << QString::number( histogram.percentile(0.5) * 1000.0, 'f', 3 )
+        << "  p99 " << QString::number( histogram.percentile(0.99) * 1000.0, 'f', 3 )
+        << "  max " << QString::number( histogram.max() * 1000.0, 'f', 3 ) << "\n";
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    app.setApplicationName("groot_monitor_benchmark");
+
+    qRegisterMetaType<AbsBehaviorTree>();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Ingest rate and frame time of the monitor, "
+                                     "against groot_fake_publisher");
+    parser.addHelpOption();
+    parser.addPositionalArgument("file", "The XML of the tree, passed to the publisher");
+
+    QCommandLineOption duration_option(QStringList() << "d" << "duration",
+                                       "Seconds of measurement. Default 10", "S", "10");
+    parser.addOption(duration_option);
+
+    QCommandLineOption rate_option(QStringList() << "r" << "rate",
+                                   "Ticks per second of the publisher. Default 50", "R", "50");
+    parser.addOption(rate_option);
+
+    QCommandLineOption burst_option(QStringList() << "b" << "burst",
+                                    "Messages sent back to back by the publisher. Default 1", "B", "1");
+    parser.addOption(burst_option);
+
+    QCommandLineOption nodes_option(QStringList() << "n" << "nodes",
+                                    "Nodes of the generated tree, without a file. Default 100", "N", "100");
+    parser.addOption(nodes_option);
+
+    QCommandLineOption publisher_option(QStringList() << "publisher",
+                                        "Path of groot_fake_publisher. Default: next to this program",
+                                        "path");
+    parser.addOption(publisher_option);
+    parser.process( app );
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    bool ok_duration = false;
+    const double duration = parser.value(duration_option).toDouble(&ok_duration);
+    if( !ok_duration || duration <= 0 )
+    {
+        err << "--duration expects a positive number" << "\n";
+        return 1;
+    }
+
+    QString publisher_path = parser.value(publisher_option);
+    if( publisher_path.isEmpty() )
+    {
+        publisher_path = QCoreApplication::applicationDirPath() + "/groot_fake_publisher";
+    }
+    QStringList publisher_args;
+    publisher_args << "--rate"  << parser.value(rate_option)
+                   << "--burst" << parser.value(burst_option)
+                   << "--nodes" << parser.value(nodes_option)
+                   << "--duration" << QString::number( duration + 10 );
+    if( !parser.positionalArguments().empty() )
+    {
+        publisher_args << QFileInfo( parser.positionalArguments().front() ).absoluteFilePath();
+    }
+
+    QProcess publisher;
+    publisher.setProcessChannelMode( QProcess::ForwardedErrorChannel );
+    publisher.start( publisher_path, publisher_args );
+    if( !publisher.waitForStarted() )
+    {
+        err << publisher_path << ": " << publisher.errorString() << "\n";
+        return 1;
+    }
+
+    MainWindow main_win( GraphicMode::MONITOR );
+    main_win.resize(1200, 800);
+    main_win.show();
+
+    zmq::context_t context(1);
+    MonitorConnection connection( context, "BehaviorTree" );
+
+    QObject::connect( &connection, &MonitorConnection::loadBehaviorTree,
+                      &main_win, [&main_win](const AbsBehaviorTree& tree, const QString& bt_name)
+    {
+        main_win.onCreateAbsBehaviorTree( tree, bt_name, false );
+    });
+    QObject::connect( &connection, &MonitorConnection::changeNodeStyle,
+                      &main_win, &MainWindow::onChangeNodesStatus );
+    QObject::connect( &connection, &MonitorConnection::addNewModel,
+                      &main_win, &MainWindow::onAddToModelRegistry );
+
+    int result = 0;
+    if( !connection.open( "tcp://localhost:1666", "tcp://localhost:1667" ) )
+    {
+        err << "can't connect: " << connection.errorString() << "\n";
+        result = 1;
+    }
+
+    const int FRAME_MS = 20;
+
+    // until the tree is received and messages are flowing
+    QElapsedTimer clock;
+    clock.start();
+    while( result == 0 && connection.state() != MonitorConnection::State::CONNECTED )
+    {
+        if( clock.elapsed() > 10000 )
+        {
+            err << "no tree from the publisher: " << connection.errorString() << "\n";
+            result = 1;
+            break;
+        }
+        connection.processMessages( true );
+        app.processEvents();
+        QThread::msleep( FRAME_MS );
+    }
+
+    if( result == 0 )
+    {
+        connection.takeStatistics();
+        const size_t dropped_before = connection.droppedMessages();
+
+        DurationHistogram ingest_time;
+        DurationHistogram frame_time;
+        size_t frames = 0;
+
+        clock.restart();
+        while( clock.elapsed() < duration * 1000.0 )
+        {
+            QElapsedTimer frame_clock;
+            frame_clock.start();
+
+            connection.processMessages( true );
+            const qint64 ingest_ns = frame_clock.nsecsElapsed();
+            app.processEvents();
+            const qint64 frame_ns = frame_clock.nsecsElapsed();
+
+            ingest_time.add( ingest_ns * 1e-9 );
+            frame_time.add( frame_ns * 1e-9 );
+            frames++;
+
+            const qint64 frame_ms = frame_ns / 1000000;
+            if( frame_ms < FRAME_MS )
+            {
+                QThread::msleep( static_cast<unsigned long>( FRAME_MS - frame_ms ) );
+            }
+        }
+
+        const MonitorConnection::Statistics stats = connection.takeStatistics();
+
+        out << "frames: " << frames << " in " << QString::number( stats.elapsed, 'f', 1 ) << " s\n";
+        out << "messages/s: "    << QString::number( stats.messages / stats.elapsed, 'f', 1 ) << "\n";
+        out << "transitions/s: " << QString::number( stats.transitions / stats.elapsed, 'f', 1 ) << "\n";
+        out << "dropped: " << connection.droppedMessages() - dropped_before
+            << "  merged: " << connection.conflatedCount()
+            << "  max queue: " << stats.queue_max << "\n";
+        PrintHistogram( out, "ingest", ingest_time );
+        PrintHistogram( out, "frame", frame_time );
+        PrintHistogram( out, "latency", stats.latency );
+    }
+
+    connection.close();
+    publisher.kill();
+    publisher.waitForFinished();
+    return result;
+}